@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// One versioned file of assets ready for upload: SPIR-V, decoded RGBA8 textures and the glyph
+// atlas with its metrics, written by the bake tool. The file is memory-mapped read-only and
+// entries are handed out as views into the mapping, so nothing is copied or decoded at startup.
+//
+// Layout: Header, Header::count_ Entry records, then the data of every entry, each aligned to
+// alignment_. Everything is little-endian, as written. Entries remember the size and modification
+// time of the file they were baked from, and find() passes over one whose source has changed since.
+class AssetPack {
+public:
+    static constexpr uint32_t magic_ = 0x5041564d; // "MVAP"
+    // bump whenever Header, Entry or the layout of any baked entry changes
+    static constexpr uint32_t version_ = 2;
+    static constexpr uint64_t alignment_ = 16;
+
+    struct Header {
+        uint32_t magic_ = AssetPack::magic_;
+        uint32_t version_ = AssetPack::version_;
+        uint32_t count_ = 0;
+        uint32_t reserved_ = 0;
+    };
+
+    struct Entry {
+        char name_[48]{};
+        uint64_t offset_ = 0;
+        uint64_t size_ = 0;
+        // for images, 0 otherwise
+        uint32_t width_ = 0;
+        uint32_t height_ = 0;
+        // of the source file when baked, both 0 when there was none
+        uint64_t sourceSize_ = 0;
+        int64_t sourceTime_ = 0;
+    };
+
+    struct View {
+        const uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+        uint32_t width_ = 0;
+        uint32_t height_ = 0;
+    };
+
+    // throws when the file can't be mapped, isn't a pack or has another version
+    explicit AssetPack(const std::string& path);
+    ~AssetPack();
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    // nothing when the entry is missing, or when source is given and no longer matches what was
+    // baked; a source that is gone can't be newer, so the entry is used then
+    std::optional<View> find(const std::string& name, const std::string& source = {}) const;
+
+    // collects entries in memory and writes a pack in one go
+    class Writer {
+    public:
+        void add(const std::string& name, const void* data, size_t size, uint32_t width = 0, uint32_t height = 0, const std::string& source = {});
+        void write(const std::string& path) const;
+    private:
+        std::vector<Entry> entries_;
+        std::vector<std::vector<uint8_t>> data_;
+    };
+private:
+    // false when the file can't be read
+    static bool stamp(const std::string& path, uint64_t& size, int64_t& time);
+    void unmap();
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    const Entry* entries_ = nullptr;
+    uint32_t count_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
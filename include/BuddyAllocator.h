@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+// Power-of-two buddy allocator over an abstract range [0, size). Blocks of
+// order n are minSize << n bytes and start at a multiple of their size, so any
+// power-of-two alignment up to the block size comes for free.
+class BuddyAllocator {
+public:
+    BuddyAllocator(uint64_t size, uint64_t minSize);
+
+    // false when no free block is large enough
+    bool allocate(uint64_t size, uint64_t alignment, uint64_t& offset, uint32_t& order);
+    void free(uint64_t offset, uint32_t order);
+
+    uint64_t size() const { return size_; }
+    uint64_t used() const { return used_; }
+    bool empty() const { return used_ == 0; }
+    uint64_t blockSize(uint32_t order) const { return minSize_ << order; }
+    uint64_t largestFree() const;
+private:
+    uint32_t orderFor(uint64_t size) const;
+
+    uint64_t size_;
+    uint64_t minSize_;
+    uint32_t maxOrder_ = 0;
+    uint64_t used_ = 0;
+    // free block offsets per order, ordered so allocations pack towards the start
+    std::vector<std::set<uint64_t>> free_;
+};
@@ -4,20 +4,39 @@
 #include <cstdint>
 #include <vulkan/vulkan.h>
 #include "Tools.h"
+#include "MemoryAllocator.h"
 
 class Buffer {
 public:
-    Buffer(VkPhysicalDevice physicalDevice, VkDevice device);
+    // without an allocator the buffer owns a vkAllocateMemory of its own
+    Buffer(VkPhysicalDevice physicalDevice, VkDevice device, MemoryAllocator* allocator = nullptr);
     ~Buffer();
 
     void init();
 
     VkBuffer buffer() const { return buffer_; }
     VkDeviceMemory memory() const { return memory_; }
+    VkDeviceSize offset() const { return allocation_.offset_; }
+    const MemoryAllocator::Allocation& allocation() const { return allocation_; }
+    // the CPU can write it directly, e.g. device-local memory behind resizable BAR; nothing here
+    // flushes mapped ranges, so non-coherent memory goes through a staging copy instead
+    bool hostVisible() const {
+        auto writable = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        return (memoryFlags_ & writable) == writable;
+    }
     void* map(VkDeviceSize size) {
         if (data_) {
             return data_;
         }
+
+        // suballocated memory is mapped once by the allocator, a second vkMapMemory on the block would be invalid
+        if (allocator_) {
+            if (!allocation_.mapped_) {
+                throw std::runtime_error("buffer memory is not host visible!");
+            }
+            data_ = allocation_.mapped_;
+            return data_;
+        }
         
         VK_CHECK(vkMapMemory(device_, memory_, 0, size, 0, &data_));
         return data_;
@@ -25,7 +44,9 @@ public:
 
     void unMap() {
         data_ = nullptr;
-        vkUnmapMemory(device_, memory_);
+        if (!allocator_) {
+            vkUnmapMemory(device_, memory_);
+        }
     }
 
 private:
@@ -34,6 +55,9 @@ private:
     VkBuffer buffer_ = VK_NULL_HANDLE;
     VkDeviceMemory memory_ = VK_NULL_HANDLE;
     void* data_ = nullptr;
+    MemoryAllocator* allocator_;
+    MemoryAllocator::Allocation allocation_{};
+    VkMemoryPropertyFlags memoryFlags_{};
     
 public:
     VkDeviceSize size_{};
@@ -43,4 +67,6 @@ public:
     uint32_t* pQueueFamilyIndices_{};
 
     VkMemoryPropertyFlags memoryProperties_{};
+    Tools::MemoryUsage memoryUsage_ = Tools::MemoryUsage::Unknown;
+    Tools::MemoryTag memoryTag_ = Tools::MemoryTag::Other;
 };
\ No newline at end of file
@@ -34,7 +34,8 @@ private:;
     float yaw_ = 0.0f;
     float pitch_ = 0.0f;
 
-    float deltaTime_;
+    // seconds since the previous frame
+    float deltaTime_ = 0.0f;
 
     float delteX_;
     float deltaY_;
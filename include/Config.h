@@ -0,0 +1,61 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <string>
+
+struct Config {
+    enum class PresentPolicy {
+        Mailbox,        // lowest latency without tearing, needs >= 3 images
+        Immediate,      // lowest latency, may tear
+        FifoRelaxed,    // vsync, tears only when a frame is late
+        Fifo,           // vsync, always available
+    };
+
+    enum class FramePacing {
+        Default,        // poll input, then wait for the swapchain image
+        JustInTime,     // wait for the swapchain image, then poll input right before recording
+    };
+
+    PresentPolicy presentPolicy_ = PresentPolicy::Mailbox;
+    FramePacing framePacing_ = FramePacing::JustInTime;
+
+    // upper bound, clamped to what the device supports; 1x relies on the coverage the shaders already output
+    VkSampleCountFlagBits msaaSamples_ = VK_SAMPLE_COUNT_4_BIT;
+    // everything is drawn in painter's order, a depth buffer is only needed for debugging 3D content
+    bool depthAttachment_ = false;
+
+    // render into a ring of offscreen images instead of a window, for render servers and CI
+    bool headless_ = false;
+    uint32_t headlessImageCount_ = 2;
+    uint32_t headlessFrames_ = 1;
+    // when set, the last headless frame is written there as PNG
+    std::string readbackPath_;
+
+    // frame time counted as a stutter, in nanoseconds; 0 uses the monitor's refresh interval
+    uint64_t frameBudget_ = 0;
+
+    // count the driver's host allocations through VkAllocationCallbacks, and optionally serve
+    // command-scope ones from a per-thread arena
+    bool trackHostAllocations_ = false;
+    bool hostArena_ = false;
+
+    // where a profiling build writes its Chrome trace on exit
+    std::string tracePath_ = "trace.json";
+
+    // glyphs are signed distance fields rendered once at the base size and scaled to any text size;
+    // the spread is how many pixels of falloff the field keeps around each outline
+    std::string fontPath_ = "../fonts/jbMono.ttf";
+    uint32_t fontBaseSize_ = 48;
+    uint32_t fontSpread_ = 8;
+    uint32_t glyphAtlasSize_ = 1024;
+    std::string canvasTexturePath_ = "../textures/canvas-texture1.jpg";
+    // the canvas texture is shown through tiles of this many texels, at most canvasTileSlots_ of
+    // them on the GPU at once (64 MiB at the defaults); clamped to maxImageArrayLayers
+    uint32_t canvasTileSize_ = 512;
+    uint32_t canvasTileSlots_ = 64;
+    // prebaked shaders, decoded textures and glyphs, see bake.cpp; empty or missing loads everything from source.
+    // an entry whose source file changed since baking loads from source, and a pack baked with other font
+    // settings is ignored for glyphs
+    std::string assetPackPath_ = "../assets.pack";
+};
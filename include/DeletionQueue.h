@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+
+// Holds replaced GPU objects until the frames that may still reference them have completed.
+// Entries are tagged with the number of frames submitted when they were retired and destroyed,
+// oldest first, once that many frames have finished.
+class DeletionQueue {
+public:
+    DeletionQueue() = default;
+    ~DeletionQueue();
+    DeletionQueue(const DeletionQueue&) = delete;
+    DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+    template<typename T>
+    void retire(uint64_t frame, std::unique_ptr<T> resource) {
+        if (resource) {
+            push(frame, std::shared_ptr<T>(std::move(resource)), nullptr);
+        }
+    }
+    template<typename T>
+    void retire(uint64_t frame, std::shared_ptr<T> resource) {
+        if (resource) {
+            push(frame, std::move(resource), nullptr);
+        }
+    }
+    // for raw handles without a wrapper, e.g. descriptor sets going back to their pool
+    void retire(uint64_t frame, std::function<void()> destroy);
+
+    void collect(uint64_t completedFrame);
+    void flush();
+    size_t size() const { return entries_.size(); }
+private:
+    struct Entry {
+        uint64_t frame_ = 0;
+        std::shared_ptr<void> resource_;
+        std::function<void()> destroy_;
+    };
+
+    void push(uint64_t frame, std::shared_ptr<void> resource, std::function<void()> destroy);
+
+    std::deque<Entry> entries_;
+};
@@ -5,9 +5,11 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+#include <glm/gtc/packing.hpp>
 
 #include "Plane.h"
-#include "Image.h"
 #include "Vertex.h"
 #include "vulkan/vulkan_core.h"
 
@@ -16,47 +18,62 @@
 
 class Font : public Plane {  
 public:
+    // opens its own library and face
     Font(const std::string& path, uint32_t size);
-
+    // a size of a face someone else owns, see FontManager; the face must outlive it and only be
+    // used by one thread at a time
+    Font(FT_Library library, FT_Face face, uint32_t size);
+    ~Font();
+    Font(const Font&) = delete;
+    Font& operator=(const Font&) = delete;
+
+    // one instance per glyph, Font.vert expands it into a quad
     VkVertexInputBindingDescription bindingDescription(uint32_t binding) const override {
         VkVertexInputBindingDescription bindingDescription{};
         bindingDescription.binding = binding;
-        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-        bindingDescription.stride = sizeof(Point);
+        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+        bindingDescription.stride = sizeof(Glyph);
 
         return bindingDescription;
     }
 
     std::vector<VkVertexInputAttributeDescription> attributeDescription(uint32_t binding) const override {
-        auto attributes = Plane::attributeDescription(binding);
-
-        VkVertexInputAttributeDescription attributeDescription{};
-        attributeDescription.binding = binding;
-        attributeDescription.location = attributes.size();
-        attributeDescription.format = VK_FORMAT_R32_UINT;
-        attributeDescription.offset = offsetof(Point, index_);
-        attributes.push_back(attributeDescription);
-
-        return attributes;
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(4);
+        attributeDescriptions[0].binding = binding;
+        attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].offset = offsetof(Glyph, position_);
+
+        attributeDescriptions[1].binding = binding;
+        attributeDescriptions[1].format = VK_FORMAT_R16G16_SFLOAT;
+        attributeDescriptions[1].location = 1;
+        attributeDescriptions[1].offset = offsetof(Glyph, size_);
+
+        attributeDescriptions[2].binding = binding;
+        attributeDescriptions[2].format = VK_FORMAT_R16G16B16A16_UNORM;
+        attributeDescriptions[2].location = 2;
+        attributeDescriptions[2].offset = offsetof(Glyph, uvRect_);
+
+        attributeDescriptions[3].binding = binding;
+        attributeDescriptions[3].format = VK_FORMAT_R8G8B8A8_UNORM;
+        attributeDescriptions[3].location = 3;
+        attributeDescriptions[3].offset = offsetof(Glyph, color_);
+
+        return attributeDescriptions;
     }
 
-    struct Point {
-        Point(float x, float y, float r, float g, float b, float u, float v, uint32_t index = 0) :
-            position_(x, y), color_(r, g, b), texCoord_(u, v), index_(index) {}
-
-        Point(glm::vec2 position, glm::vec3 color, glm::vec2 texCoord, uint32_t index = 0) : 
-            position_(position), color_(color), texCoord_(texCoord), index_(index) {}
-
-        Point(Plane::Point point, uint32_t index) : 
-            position_(point.position_), color_(point.color_), texCoord_(point.texCoord_), index_(index) {}
-
-        Point() {}
-
+    // 24 bytes instead of 4 vertices and 6 indices
+    struct Glyph {
+        // lower left corner
         glm::vec2 position_{};
-        glm::vec3 color_{};
-        glm::vec2 texCoord_{};
-        uint32_t index_{};
+        // uvMin and uvMax in the atlas, 16 bit normalized
+        uint64_t uvRect_{};
+        // half floats, in the same units as position
+        uint32_t size_{};
+        // rgba8
+        uint32_t color_{};
     };
+    static_assert(sizeof(Glyph) == 24, "Font.vert reads Glyph as vertex attributes");
 
     struct Character {
         Character() {}
@@ -67,71 +84,64 @@ public:
         uint32_t width_{};
         uint32_t height_{};
         int advance_{};
-        uint32_t index_{};
         glm::vec3 color_ = glm::vec3(0.0f, 0.0f, 0.0f);
-        std::shared_ptr<Image> image_;
+        // where the bitmap sits in the glyph atlas, in normalized texture coordinates
+        glm::vec2 uvMin_{};
+        glm::vec2 uvMax_{};
     };
 
-    static std::pair<std::vector<Point>, std::vector<uint32_t>> vertices(float x, float y, const Character& character, glm::vec3 color) {
-        // x += character.offsetX_;
-        // y += character.offsetY_;
-        // x += character.width_ / 2.0f;
-        // y -= character.height_ / 2.0f;
-
-        auto width = character.width_, height = character.height_;
-        
-        auto index = character.index_;
-
-        auto t = Plane::vertices(x, y, width, height, color);
-        std::vector<Point> points;
-        for (size_t i = 0; i < t.first.size(); i++) {
-            points.emplace_back(Point(t.first[i], index));
-        }
-
-        return {points, t.second};
-    }
-
-    typedef std::pair<std::vector<Point>, std::vector<uint32_t>> PairPointIndex;
-    static PairPointIndex mergeVertices(PairPointIndex p1, PairPointIndex p2) {
-        auto size = p1.first.size();
-
-        for (size_t i = 0; i < p2.first.size(); i++) {
-            p1.first.push_back(p2.first[i]);
-        }
-        for (size_t i = 0; i < p2.second.size(); i++) {
-            p1.second.push_back(p2.second[i] + size);
-        }
+    // a rendered glyph, owning its pixels so it can cross threads
+    struct Bitmap {
+        uint32_t codepoint_{};
+        int offsetX_{};
+        int offsetY_{};
+        uint32_t width_{};
+        uint32_t height_{};
+        int advance_{};
+        std::vector<uint8_t> pixels_;
+    };
 
-        return p1;
+    // the instance drawing character with its pen at x, y
+    static Glyph instance(float x, float y, const Character& character, float scale = 1.0f) {
+        Glyph glyph;
+        glyph.position_ = glm::vec2(x + character.offsetX_ * scale, y + (character.offsetY_ - static_cast<float>(character.height_)) * scale);
+        glyph.size_ = glm::packHalf2x16(glm::vec2(character.width_ * scale, character.height_ * scale));
+        glyph.uvRect_ = glm::packUnorm4x16(glm::vec4(character.uvMin_.x, character.uvMin_.y, character.uvMax_.x, character.uvMax_.y));
+        glyph.color_ = glm::packUnorm4x8(glm::vec4(character.color_, 1.0f));
+        return glyph;
     }
 
-    static PairPointIndex generateText(float x, float y, const std::string& text, const std::unordered_map<char, Character>& dictionary) {
-        PairPointIndex pointAndIndex;
-        for (auto& c : text) {
-            glm::vec2 center;
-            center.x = x + dictionary.at(c).offsetX_ + dictionary.at(c).width_ / 2.0f;
-            center.y = y + dictionary.at(c).offsetY_ - dictionary.at(c).height_ / 2.0f;
-            auto t = Font::vertices(center.x, center.y, dictionary.at(c), dictionary.at(c).color_);
-            
-            for (auto& point : t.first) {
-                point.texCoord_.y = 1.0f - point.texCoord_.y;
-            }
-
-            pointAndIndex = Font::mergeVertices(pointAndIndex, t);
-
-            x += dictionary.at(c).advance_;
+    // glyph(codepoint) returns the Character to draw; scale maps the size the glyphs were
+    // rendered at to the size the text is drawn at. Text that changes a little at a time
+    // belongs in a TextLayout, this lays out everything again.
+    template<typename GlyphLookup>
+    static std::vector<Glyph> generateText(float x, float y, const std::u32string& text, GlyphLookup&& glyph, float scale = 1.0f) {
+        std::vector<Glyph> glyphs;
+        glyphs.reserve(text.size());
+        for (auto c : text) {
+            auto character = glyph(c);
+            glyphs.push_back(Font::instance(x, y, character, scale));
+            x += character.advance_ * scale;
         }
 
-        return pointAndIndex;
+        return glyphs;
     }
 
     void loadChar(char c);
+    // signed distance field of one glyph: 128 on the outline, higher inside, spread pixels of falloff
+    Bitmap renderSdf(uint32_t codepoint, uint32_t spread);
+    // FreeType faces aren't thread-safe, so every worker opens the file with its own library and face
+    static std::vector<Bitmap> renderSdf(const std::string& path, uint32_t size, const std::vector<uint32_t>& codepoints, uint32_t spread, uint32_t threads = 0);
     void renderMode(FT_Render_Mode mode);
     FT_Bitmap bitmap() { return face_->glyph->bitmap; }
     FT_GlyphSlot glyph() { return face_->glyph; }
 private:
     void check(FT_Error error);
+    // a shared face has one current size, make it ours before loading a glyph
+    void activate();
 
     FT_Library libarry_;
     FT_Face face_;
+    FT_Size size_ = nullptr;
+    bool ownsFace_ = true;
 };
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+#include "GlyphCache.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+// One FreeType library for the whole program. Every font file is opened and parsed once, and
+// every pixel size of it gets its own glyph cache on first use, one per spread and atlas size,
+// all sharing that face. Lookups may come from any thread; the caches themselves belong to the
+// thread that draws with them.
+class FontManager {
+public:
+    FontManager();
+    ~FontManager();
+    FontManager(const FontManager&) = delete;
+    FontManager& operator=(const FontManager&) = delete;
+
+    FT_Library library() const { return library_; }
+    // the parsed face of a font file, opened on first use
+    FT_Face face(const std::string& path);
+    // the glyph cache for one file at one pixel size, spread and atlas size, created on first use
+    GlyphCache& glyphs(const std::string& path, uint32_t size, uint32_t spread, uint32_t atlasSize);
+
+    size_t faceCount() const;
+    size_t glyphSetCount() const;
+private:
+    FT_Face openFace(const std::string& path);
+
+    FT_Library library_ = nullptr;
+    std::unordered_map<std::string, FT_Face> faces_;
+    // destroyed before the faces, their sizes belong to them
+    std::map<std::tuple<std::string, uint32_t, uint32_t, uint32_t>, std::unique_ptr<GlyphCache>> glyphSets_;
+    mutable std::mutex mutex_;
+};
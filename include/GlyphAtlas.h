@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Single-channel texture atlas packed in shelves: glyphs of similar height share a row, and a new
+// row opens below the last one when none fits. Pixels are kept on the CPU; changed regions are
+// recorded so the GPU copy can be updated piecewise. Space is reclaimed a whole shelf at a time.
+class GlyphAtlas {
+public:
+    struct Rect {
+        uint32_t x_ = 0;
+        uint32_t y_ = 0;
+        uint32_t width_ = 0;
+        uint32_t height_ = 0;
+        uint32_t shelf_ = 0;
+    };
+
+    GlyphAtlas(uint32_t width, uint32_t height, uint32_t padding = 1);
+
+    // copies a width x height bitmap with the given row pitch in, nullopt when it doesn't fit
+    std::optional<Rect> insert(uint32_t width, uint32_t height, const uint8_t* pixels, uint32_t pitch);
+    // would a glyph this tall fit into shelf once it was emptied
+    bool fits(uint32_t shelf, uint32_t height) const { return shelves_[shelf].height_ >= height + padding_; }
+    // blanks a shelf so its space can be reused; the caller drops every glyph it held
+    void evictShelf(uint32_t shelf);
+    void clear();
+
+    // regions changed since the last call, none overlapping
+    std::vector<Rect> takeDirty();
+
+    uint32_t width() const { return width_; }
+    uint32_t height() const { return height_; }
+    uint32_t shelfCount() const { return static_cast<uint32_t>(shelves_.size()); }
+    const std::vector<uint8_t>& pixels() const { return pixels_; }
+
+    struct Shelf {
+        uint32_t y_ = 0;
+        uint32_t height_ = 0;
+        uint32_t x_ = 0;
+    };
+    const std::vector<Shelf>& shelves() const { return shelves_; }
+    // takes over a packing saved from shelves() and pixels(), nothing is marked dirty
+    void restore(const std::vector<Shelf>& shelves, const uint8_t* pixels);
+private:
+
+    void markDirty(const Rect& rect);
+
+    uint32_t width_;
+    uint32_t height_;
+    // blank texels around every glyph so linear filtering never picks up a neighbour;
+    // it also keeps the texel at (0, 0) blank for glyphs without a bitmap to point at
+    uint32_t padding_;
+    // shelf heights are rounded up so an emptied shelf suits more than the exact glyph that opened it
+    static constexpr uint32_t shelfGranularity_ = 8;
+    std::vector<Shelf> shelves_;
+    std::vector<uint8_t> pixels_;
+    std::vector<Rect> dirty_;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AssetPack.h"
+#include "Font.h"
+#include "GlyphAtlas.h"
+
+// Glyphs by codepoint, rendered into the atlas the first time they are asked for. When the atlas
+// is full the least recently used shelf is emptied, unless a frame that may still be on the GPU
+// drew one of its glyphs. Evicted glyphs are simply rendered again on their next use.
+class GlyphCache {
+public:
+    GlyphCache(const std::string& path, uint32_t size, uint32_t spread, uint32_t atlasSize);
+    // renders through a face shared with other sizes, see FontManager
+    GlyphCache(FT_Library library, FT_Face face, const std::string& path, uint32_t size, uint32_t spread, uint32_t atlasSize);
+
+    // renders codepoints ahead of time across worker threads
+    void preload(const std::vector<uint32_t>& codepoints);
+    // frame is the one being recorded, glyphs last drawn before completedFrame may be evicted
+    void beginFrame(uint64_t frame, uint64_t completedFrame);
+    Font::Character glyph(char32_t codepoint);
+
+    // stores the cache as it is now, atlas included, under glyphs/ in a pack
+    void bake(AssetPack::Writer& writer) const;
+    // replaces the cache with a baked one; false, leaving the cache alone, when the pack has none
+    // or it was baked from another font file or with other settings
+    bool restore(const AssetPack& pack);
+
+    GlyphAtlas& atlas() { return atlas_; }
+    size_t size() const { return glyphs_.size(); }
+    uint64_t evictions() const { return evictions_; }
+private:
+    struct BakedInfo {
+        uint32_t size_ = 0;
+        uint32_t spread_ = 0;
+        uint32_t atlasSize_ = 0;
+        uint32_t fontBytes_ = 0;
+    };
+    struct BakedGlyph {
+        uint32_t codepoint_ = 0;
+        int32_t offsetX_ = 0;
+        int32_t offsetY_ = 0;
+        uint32_t width_ = 0;
+        uint32_t height_ = 0;
+        int32_t advance_ = 0;
+        uint32_t x_ = 0;
+        uint32_t y_ = 0;
+        uint32_t shelf_ = 0;
+        uint32_t packed_ = 0;
+    };
+    BakedInfo info() const;
+
+    struct Entry {
+        Font::Character character_;
+        uint32_t shelf_ = 0;
+        bool packed_ = false;
+    };
+
+    Font::Character add(const Font::Bitmap& bitmap);
+    bool evict(uint32_t height);
+
+    Font font_;
+    std::string path_;
+    uint32_t size_;
+    uint32_t spread_;
+    GlyphAtlas atlas_;
+    std::unordered_map<char32_t, Entry> glyphs_;
+    // codepoints packed into each shelf, and the last frame any of them was drawn in
+    std::vector<std::vector<char32_t>> shelfGlyphs_;
+    std::vector<uint64_t> shelfLastUse_;
+    uint64_t frame_ = 0;
+    uint64_t completedFrame_ = 0;
+    uint64_t evictions_ = 0;
+    glm::vec2 blankUv_{};
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// VkAllocationCallbacks that count the driver's host allocations per object type and per
+// allocation scope. Command-scope allocations only live for the duration of a single vkCreate* /
+// vkCmd* call, so they can optionally be served from a thread-local bump arena instead of malloc.
+// Disabled by default, in which case callbacks() returns nullptr and the driver uses its own.
+class HostAllocator {
+public:
+    enum class ObjectType {
+        Instance,
+        Device,
+        Memory,
+        Buffer,
+        Image,
+        Sampler,
+        Pipeline,
+        Shader,
+        RenderPass,
+        FrameBuffer,
+        Descriptor,
+        Command,
+        Sync,
+        Query,
+        SwapChain,
+        Count,
+    };
+    static constexpr size_t scopeCount_ = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+    struct Counters {
+        uint64_t allocations_ = 0;
+        uint64_t reallocations_ = 0;
+        uint64_t frees_ = 0;
+        uint64_t arenaAllocations_ = 0;
+        // live bytes and the most that were ever live at once
+        uint64_t bytes_ = 0;
+        uint64_t peakBytes_ = 0;
+    };
+    struct Stats {
+        std::array<std::array<Counters, scopeCount_>, static_cast<size_t>(ObjectType::Count)> counters_{};
+        // allocations the driver makes itself and only reports, e.g. executable memory
+        uint64_t internalBytes_ = 0;
+
+        Counters total(ObjectType type) const;
+        Counters total() const;
+    };
+
+    static HostAllocator& instance();
+    static const char* name(ObjectType type);
+
+    // must be called before the first Vulkan object is created: callbacks passed to vkCreate* have
+    // to match the ones passed to the vkDestroy* call
+    void enable(bool arena);
+    bool enabled() const { return enabled_; }
+
+    // nullptr while disabled, so every wrapper can pass it unconditionally
+    static const VkAllocationCallbacks* callbacks(ObjectType type);
+
+    Stats stats() const;
+    // host allocations made so far, to diff between frames
+    uint64_t allocations() const;
+    std::string summary() const;
+
+private:
+    HostAllocator();
+
+    struct AtomicCounters {
+        std::atomic<uint64_t> allocations_{0};
+        std::atomic<uint64_t> reallocations_{0};
+        std::atomic<uint64_t> frees_{0};
+        std::atomic<uint64_t> arenaAllocations_{0};
+        std::atomic<uint64_t> bytes_{0};
+        std::atomic<uint64_t> peakBytes_{0};
+    };
+    struct Tracker {
+        HostAllocator* allocator_ = nullptr;
+        ObjectType type_ = ObjectType::Count;
+        std::array<AtomicCounters, scopeCount_> counters_;
+    };
+
+    static void* VKAPI_PTR allocation(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope);
+    static void* VKAPI_PTR reallocation(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+    static void VKAPI_PTR free(void* userData, void* memory);
+    static void VKAPI_PTR internalAllocation(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+    static void VKAPI_PTR internalFree(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+
+    void* allocate(Tracker& tracker, size_t size, size_t alignment, VkSystemAllocationScope scope);
+    static void release(void* memory);
+    static size_t sizeOf(void* memory);
+
+    bool enabled_ = false;
+    bool arena_ = false;
+    std::array<Tracker, static_cast<size_t>(ObjectType::Count)> trackers_;
+    std::array<VkAllocationCallbacks, static_cast<size_t>(ObjectType::Count)> callbacks_{};
+    std::atomic<uint64_t> internalBytes_{0};
+};
@@ -3,10 +3,12 @@
 #include "vulkan/vulkan_core.h"
 #include <cstdint>
 #include <vulkan/vulkan.h>
+#include "MemoryAllocator.h"
 
 class Image {
 public:
-    Image(VkPhysicalDevice physicalDevice, VkDevice device);
+    // without an allocator the image owns a vkAllocateMemory of its own
+    Image(VkPhysicalDevice physicalDevice, VkDevice device, MemoryAllocator* allocator = nullptr);
     Image& operator=(const Image& rhs) = default;
     ~Image();
     
@@ -14,6 +16,8 @@ public:
     VkImage image() const { return image_; }
     VkImageView view() const { return view_; }
     VkDeviceMemory memory() const { return memory_; }
+    VkDeviceSize offset() const { return allocation_.offset_; }
+    const MemoryAllocator::Allocation& allocation() const { return allocation_; }
     
 private:
     VkPhysicalDevice physicalDevice_;
@@ -21,6 +25,8 @@ private:
     VkImage image_;
     VkImageView view_;
     VkDeviceMemory memory_;
+    MemoryAllocator* allocator_;
+    MemoryAllocator::Allocation allocation_{};
     
 public:
     VkImageType imageType_{};
@@ -37,6 +43,10 @@ public:
     uint32_t* pQueueFamilyIndices_{};    
 
     VkMemoryPropertyFlags memoryProperties_{};
+    // used when some memory type offers them on top of memoryProperties_, e.g. LAZILY_ALLOCATED for transient attachments
+    VkMemoryPropertyFlags preferredMemoryProperties_{};
+    Tools::MemoryUsage memoryUsage_ = Tools::MemoryUsage::Unknown;
+    Tools::MemoryTag memoryTag_ = Tools::MemoryTag::Other;
 
     VkImageViewType viewType_{};
     VkImageSubresourceRange subresourcesRange_{};
@@ -44,6 +44,10 @@ public:
         return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
     }
     
+    // texCoord_.x of a point is how far inside a brush stroke it is, in pixels; brush.frag covers
+    // the pixel fully from here on and not at all at -inside_
+    static constexpr float inside_ = 0.5f;
+
     struct Point {
         Point() {}
         glm::vec2 position_{};
@@ -61,6 +65,7 @@ public:
                 Point point{};
                 point.position_ = glm::vec2(i, j);
                 point.color_ = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+                point.texCoord_ = glm::vec2(inside_, 0.0f);
                 vertices.push_back(point);
                 indices.push_back(a++);
             }
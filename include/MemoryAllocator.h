@@ -0,0 +1,117 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include <vulkan/vulkan.h>
+#include "BuddyAllocator.h"
+#include "Tools.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Suballocates device memory out of large per-memory-type blocks instead of
+// one vkAllocateMemory per resource. Buffers and linear images never share a
+// block with optimal images, which keeps bufferImageGranularity out of the picture.
+class MemoryAllocator {
+public:
+    enum class Kind {
+        Linear,     // buffers and linear-tiling images
+        Optimal,    // optimal-tiling images
+    };
+
+    struct Allocation {
+        VkDeviceMemory memory_ = VK_NULL_HANDLE;
+        VkDeviceSize offset_ = 0;
+        VkDeviceSize size_ = 0;         // reserved, may be more than requested
+        void* mapped_ = nullptr;        // host-visible memory stays mapped; already offset
+        uint32_t memoryType_ = 0;
+        VkMemoryPropertyFlags flags_ = 0;     // of the chosen memory type
+        Kind kind_ = Kind::Linear;
+        Tools::MemoryTag tag_ = Tools::MemoryTag::Other;
+        bool dedicated_ = false;
+        uint32_t order_ = 0;
+        void* block_ = nullptr;
+    };
+
+    struct TagStats {
+        VkDeviceSize bytes_ = 0;
+        uint32_t count_ = 0;
+    };
+
+    struct HeapStats {
+        VkDeviceSize size_ = 0;
+        bool deviceLocal_ = false;
+        VkDeviceSize reserved_ = 0;     // by this allocator
+        // from VK_EXT_memory_budget when available: the whole process's usage and what the driver lets us have.
+        // Without it, usage is our own reservation and budget is the heap size.
+        VkDeviceSize usage_ = 0;
+        VkDeviceSize budget_ = 0;
+    };
+
+    struct Stats {
+        uint32_t blocks_ = 0;
+        uint32_t dedicated_ = 0;
+        uint32_t allocations_ = 0;
+        VkDeviceSize reserved_ = 0;     // device memory held
+        VkDeviceSize used_ = 0;         // handed out to resources
+        std::array<TagStats, static_cast<size_t>(Tools::MemoryTag::Count)> tags_{};
+        std::vector<HeapStats> heaps_;
+        bool budgetExtension_ = false;
+    };
+
+    MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device);
+    ~MemoryAllocator();
+
+    // a usage other than Unknown picks the memory type by score and ignores preferred; the image or
+    // buffer the memory is for is named to the driver when it ends up in its own allocation
+    Allocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferred, Tools::MemoryUsage usage, Tools::MemoryTag tag, Kind kind, bool dedicated = false, VkImage image = VK_NULL_HANDLE, VkBuffer buffer = VK_NULL_HANDLE);
+    void free(Allocation& allocation);
+    Stats stats();
+
+    // Defragmentation picks the emptiest block whose contents fit into the rest of its pool and stops
+    // placing allocations there. The caller moves what it can out of it, then ends the pass to free it.
+    // A block the pass couldn't empty isn't picked again until something is allocated in it or freed from it.
+    bool beginDefragmentation();
+    bool defragmenting() const { return evacuating_ != nullptr; }
+    bool evacuating(const Allocation& allocation) const { return evacuating_ && allocation.block_ == evacuating_; }
+    VkDeviceSize evacuatingUsed();
+    // frees every empty block and returns the bytes given back to the driver
+    VkDeviceSize endDefragmentation();
+
+    // resources larger than half a block get their own allocation
+    VkDeviceSize blockSize_ = 64ull << 20;
+    VkDeviceSize minAllocation_ = 256;
+    // set when the device was created with VK_EXT_memory_budget
+    bool memoryBudget_ = false;
+private:
+    struct Block {
+        VkDeviceMemory memory_ = VK_NULL_HANDLE;
+        void* mapped_ = nullptr;
+        std::unique_ptr<BuddyAllocator> buddy_;
+        // what is left in it couldn't be moved out the last time it was evacuated
+        bool stuck_ = false;
+    };
+
+    struct Pool {
+        std::vector<std::unique_ptr<Block>> blocks_;
+    };
+
+    Allocation allocateDedicated(VkDeviceSize size, uint32_t memoryType, Kind kind, VkImage image, VkBuffer buffer);
+    VkDeviceMemory allocateMemory(VkDeviceSize size, uint32_t memoryType, void** mapped, const void* next = nullptr);
+    void freeMemory(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryType);
+    Pool& pool(uint32_t memoryType, Kind kind) { return pools_[memoryType * 2 + static_cast<uint32_t>(kind)]; }
+    uint32_t memoryTypeOf(const Pool& pool) const { return static_cast<uint32_t>(&pool - pools_.data()) / 2; }
+
+    VkPhysicalDevice physicalDevice_;
+    VkDevice device_;
+    VkPhysicalDeviceMemoryProperties memoryProperties_{};
+    std::mutex mutex_;
+    std::vector<Pool> pools_;
+    uint32_t dedicatedCount_ = 0;
+    VkDeviceSize dedicatedBytes_ = 0;
+    uint32_t allocationCount_ = 0;
+    std::array<TagStats, static_cast<size_t>(Tools::MemoryTag::Count)> tags_{};
+    std::vector<VkDeviceSize> heapReserved_;
+    Block* evacuating_ = nullptr;
+};
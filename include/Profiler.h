@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Collects CPU scopes and GPU pass timings and writes them as a Chrome trace
+// (open in chrome://tracing or ui.perfetto.dev). Nothing is recorded unless the
+// build defines ENABLE_PROFILER; otherwise PROFILE_SCOPE expands to nothing.
+class Profiler {
+public:
+    static Profiler& instance();
+
+    // times are nanoseconds on Timer::nowNanoseconds's clock; names must outlive the profiler
+    void addCpuEvent(const char* name, uint64_t begin, uint64_t end);
+    void addGpuEvent(const char* name, uint64_t begin, uint64_t end);
+
+    bool save(const std::string& path);
+    void clear();
+
+    class Scope {
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+    private:
+        const char* name_;
+        uint64_t begin_;
+    };
+
+private:
+    Profiler();
+
+    struct Event {
+        const char* name_;
+        const char* category_;
+        uint64_t begin_;
+        uint64_t end_;
+        uint32_t thread_;
+    };
+
+    void addEvent(const char* name, const char* category, uint64_t begin, uint64_t end, uint32_t thread);
+    static uint32_t currentThread();
+
+    // GPU work gets its own track, CPU threads are numbered from 1
+    static constexpr uint32_t gpuThread_ = 0;
+    // a long session would otherwise grow without bound
+    static constexpr size_t maxEvents_ = 1 << 20;
+
+    std::mutex mutex_;
+    std::vector<Event> events_;
+    uint64_t dropped_ = 0;
+    uint64_t origin_ = 0;
+};
+
+#ifdef ENABLE_PROFILER
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
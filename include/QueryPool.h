@@ -0,0 +1,22 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+class QueryPool {
+public:
+    QueryPool(VkDevice device);
+    ~QueryPool();
+
+    void init();
+    VkQueryPool queryPool() const { return queryPool_; }
+
+    void*                           pNext_{};
+    VkQueryType                     queryType_ = VK_QUERY_TYPE_TIMESTAMP;
+    uint32_t                        queryCount_{};
+    VkQueryPipelineStatisticFlags   pipelineStatistics_{};
+private:
+    VkDevice device_;
+    VkQueryPool queryPool_ = VK_NULL_HANDLE;
+};
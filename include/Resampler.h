@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Resizes RGBA8 sRGB images with a separable filter. Colors are filtered as premultiplied linear
+// light, so dark and transparent texels don't bleed into their neighbours, and converted back
+// to sRGB through tables. Output rows are split into bands across worker threads; each band
+// filters only the source rows it reads, so memory stays at a few bands of the output width.
+class Resampler {
+public:
+    enum class Filter {
+        Box,        // average of the texels whose centres an output texel covers, for halvings: 2x2
+                    // for even sizes, while halving an odd size up leaves some outputs one texel wide
+        Lanczos3,   // sharp, for large reductions of photos
+    };
+
+    // threads 0 uses every core; small outputs use fewer, down to only the calling thread
+    static std::vector<uint8_t> resize(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t outWidth, uint32_t outHeight, Filter filter, uint32_t threads = 0);
+};
@@ -3,14 +3,20 @@
 #include "vulkan/vulkan_core.h"
 #include <vulkan/vulkan.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 class ShaderModule {
 public:
     ShaderModule(VkDevice device, const std::string& path);
+    // SPIR-V already in memory, e.g. in a mapped asset pack; size in bytes
+    ShaderModule(VkDevice device, const uint32_t* code, size_t size);
 
     VkShaderModule shader() const { return shader_; }
 private:
+    void create(const uint32_t* code, size_t size);
+
     VkDevice device_;
     VkShaderModule shader_;
 };
\ No newline at end of file
@@ -6,6 +6,9 @@
 #include <vulkan/vulkan.h>
 
 #include <vector>
+#include <memory>
+
+#include "Image.h"
 
 class SwapChain {
 public:
@@ -13,6 +16,9 @@ public:
     ~SwapChain();
 
     void init();
+    // headless: minImageCount_ plain images stand in for the presentable ones
+    void initOffscreen(VkPhysicalDevice physicalDevice, MemoryAllocator* allocator = nullptr);
+    bool offscreen() const { return !offscreenImages_.empty(); }
     VkSwapchainKHR swapChain() const { return swapChain_; }
     size_t size() const { return images_.size(); }
     VkImage image(uint32_t idx) const { return images_[idx]; }
@@ -40,9 +46,10 @@ public:
     VkSwapchainKHR                   oldSwapchain_{};
 private:
     VkDevice device_;
-    VkSwapchainKHR swapChain_;
+    VkSwapchainKHR swapChain_ = VK_NULL_HANDLE;
     VkFormat format_;
     VkExtent2D extent_;
     std::vector<VkImage> images_;
     std::vector<VkImageView> imageViews_;
+    std::vector<std::unique_ptr<Image>> offscreenImages_;
 };
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Font.h"
+
+// Glyph instances of one line of text, kept between frames. Updating it with new text only lays
+// out what follows the first changed codepoint, so typing or deleting a character touches one glyph.
+class TextLayout {
+public:
+    using GlyphLookup = std::function<Font::Character(char32_t)>;
+
+    // x, y is the pen origin, scale maps glyph pixels to text size; changing either relays everything
+    void update(float x, float y, float scale, const std::u32string& text, const GlyphLookup& glyph);
+    // forget the layout, e.g. once glyphs it references moved in the atlas
+    void invalidate();
+
+    const std::vector<Font::Glyph>& glyphs() const { return glyphs_; }
+    uint32_t size() const { return static_cast<uint32_t>(glyphs_.size()); }
+    // glyphs rewritten since the last call, [first, second), empty when first >= second
+    std::pair<uint32_t, uint32_t> takeDirty();
+private:
+    std::u32string text_;
+    // pen x before every glyph, one more entry for the pen after the last
+    std::vector<float> pens_;
+    std::vector<Font::Glyph> glyphs_;
+    float x_ = 0.0f;
+    float y_ = 0.0f;
+    float scale_ = 0.0f;
+    uint32_t dirtyBegin_ = UINT32_MAX;
+    uint32_t dirtyEnd_ = 0;
+};
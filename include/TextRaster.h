@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "Font.h"
+#include "GlyphAtlas.h"
+
+// Draws glyphs out of the signed distance field atlas on the CPU, the same way Font.frag does on
+// the GPU. Used to commit text into the ink once instead of drawing it every frame.
+class TextRaster {
+public:
+    // spread is the falloff the atlas' fields were rendered with
+    TextRaster(const GlyphAtlas& atlas, uint32_t spread);
+
+    // calls plot(x, y, coverage) for every pixel the glyph touches; the pen is at x, y, y up
+    void glyph(float x, float y, const Font::Character& character, float scale, const std::function<void(int, int, float)>& plot) const;
+
+    // straight alpha src over dst, both rgba
+    static void blendOver(float* dst, const float* src);
+private:
+    // bilinear, in atlas texels, 0..1
+    float sample(float x, float y) const;
+
+    const GlyphAtlas& atlas_;
+    uint32_t spread_;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// An RGBA8 image of any size, cut into square tiles over a pyramid of levels that each halve the
+// one before. A view only makes the tiles it sees at the one level it needs resident, in a fixed
+// number of slots of a GPU array image, so neither the image's size nor maxImageDimension2D bounds
+// what can be shown. Every kept level stays in host memory though: that side is bounded by
+// maxExtent, about a third more than one maxExtent-sized level, not by the slots.
+class TiledImage {
+public:
+    // texels every tile repeats from its neighbours on each side, so linear filtering never reads
+    // across a tile edge
+    static constexpr uint32_t gutter_ = 1;
+    // table() starts with this many words: columns, rows, level width, level height, tile size,
+    // stride, gutter and one unused
+    static constexpr uint32_t tableHeader_ = 8;
+    static constexpr uint32_t notResident_ = UINT32_MAX;
+
+    // part of the image in [0, 1] texture coordinates
+    struct Rect {
+        float x0_ = 0.0f;
+        float y0_ = 0.0f;
+        float x1_ = 1.0f;
+        float y1_ = 1.0f;
+    };
+
+    struct Upload {
+        uint32_t slot_ = 0;
+        // tileSize x tileSize RGBA8 texels, owned by the image
+        const uint8_t* pixels_ = nullptr;
+    };
+
+    // levels finer than what a view of maxExtent pixels across needs are dropped while building
+    TiledImage(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t tileSize, uint32_t slots, uint32_t maxExtent);
+
+    // picks the level for showing view at viewWidth x viewHeight pixels and makes the tiles it
+    // covers resident, evicting the least recently shown ones; returns the tiles to copy into
+    // their slots before the next draw that reads table()
+    std::vector<Upload> update(const Rect& view, uint32_t viewWidth, uint32_t viewHeight);
+
+    // what the canvas shader reads to find a texel: the header, then the slot of every tile of
+    // the current level row by row, notResident_ for the ones not shown
+    const std::vector<uint32_t>& table() const { return table_; }
+    // words the table can grow to, for sizing its buffer up front
+    uint32_t maxTableSize() const;
+    // true once after update() changed the table
+    bool takeTableDirty();
+
+    uint32_t width() const { return width_; }
+    uint32_t height() const { return height_; }
+    uint32_t tileSize() const { return tileSize_; }
+    uint32_t slots() const { return static_cast<uint32_t>(slots_.size()); }
+    uint32_t levels() const { return static_cast<uint32_t>(levels_.size()); }
+    // pyramid level of the source image that levels_[0] is
+    uint32_t firstLevel() const { return firstLevel_; }
+    uint32_t currentLevel() const { return current_; }
+    size_t hostBytes() const;
+private:
+    struct Level {
+        uint32_t width_ = 0;
+        uint32_t height_ = 0;
+        uint32_t columns_ = 0;
+        uint32_t rows_ = 0;
+        std::vector<std::vector<uint8_t>> tiles_;
+    };
+    struct Slot {
+        uint64_t key_ = UINT64_MAX;
+        uint64_t lastUse_ = 0;
+    };
+
+    void slice(const uint8_t* rgba, uint32_t width, uint32_t height);
+    static uint64_t key(uint32_t level, uint32_t tile) { return (static_cast<uint64_t>(level) << 32) | tile; }
+
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t tileSize_;
+    uint32_t stride_;
+    uint32_t firstLevel_ = 0;
+    std::vector<Level> levels_;
+    std::vector<Slot> slots_;
+    // slot of every resident tile, by key()
+    std::unordered_map<uint64_t, uint32_t> resident_;
+    uint32_t current_ = UINT32_MAX;
+    uint64_t use_ = 0;
+    std::vector<uint32_t> table_;
+    bool tableDirty_ = false;
+};
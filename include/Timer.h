@@ -2,14 +2,18 @@
 
 #include <chrono>
 
+// steady_clock: high_resolution_clock may be the wall clock and jump
 class Timer {
 public:
     Timer();
 
     void tick();
+    unsigned long long deltaNanoseconds() const;
     unsigned long long deltaMilliseconds() const;
+    double deltaSeconds() const;
     static unsigned long long nowMilliseconds();
+    static unsigned long long nowNanoseconds();
 private:
-    std::chrono::time_point<std::chrono::high_resolution_clock> prevTime_;
-    std::chrono::time_point<std::chrono::high_resolution_clock> currentTime_;
-};
\ No newline at end of file
+    std::chrono::time_point<std::chrono::steady_clock> prevTime_;
+    std::chrono::time_point<std::chrono::steady_clock> currentTime_;
+};
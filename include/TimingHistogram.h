@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Rolling window of durations in nanoseconds. Stutter shows up in the tail
+// percentiles long before it moves the average.
+class TimingHistogram {
+public:
+    explicit TimingHistogram(size_t capacity = 1024, uint64_t budget = 0);
+
+    struct Stats {
+        uint64_t count_ = 0;            // samples in the window
+        uint64_t p50_ = 0;
+        uint64_t p95_ = 0;
+        uint64_t p99_ = 0;
+        uint64_t max_ = 0;
+        uint64_t overBudget_ = 0;       // in the window
+        uint64_t total_ = 0;            // since the last reset
+        uint64_t totalOverBudget_ = 0;  // since the last reset
+    };
+
+    void record(uint64_t nanoseconds);
+    void reset();
+    Stats stats() const;
+    // one line with every value in milliseconds
+    std::string summary(const std::string& name) const;
+
+    void setBudget(uint64_t nanoseconds) { budget_ = nanoseconds; }
+    uint64_t budget() const { return budget_; }
+private:
+    std::vector<uint64_t> samples_;
+    size_t next_ = 0;
+    size_t size_ = 0;
+    uint64_t budget_ = 0;
+    uint64_t total_ = 0;
+    uint64_t totalOverBudget_ = 0;
+};
@@ -58,7 +58,12 @@ struct QueueFamilyIndices {
             }
 
             VkBool32 presentSupport = VK_FALSE;
-            vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport);
+            if (surface != VK_NULL_HANDLE) {
+                vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport);
+            } else {
+                // headless, nothing is presented and the graphics queue stands in
+                presentSupport = (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) ? VK_TRUE : VK_FALSE;
+            }
             if (presentSupport) {
                 indices.present = i;
             }
@@ -106,16 +111,59 @@ struct SwapChainSupportDetail {
         }
     }
 
-    VkPresentModeKHR choosePresentMode() const {
-        for (const auto& mode : presentModes_) {
-            if (mode == VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR) {
+    bool supportPresentMode(VkPresentModeKHR presentMode) const {
+        return std::find(presentModes_.begin(), presentModes_.end(), presentMode) != presentModes_.end();
+    }
+
+    VkPresentModeKHR choosePresentMode(VkPresentModeKHR preferred) const {
+        std::vector<VkPresentModeKHR> candidates;
+        switch (preferred) {
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+            // immediate tears whenever a present lands mid scanout, so only the Immediate policy gets it
+            candidates = {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR};
+            break;
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+            candidates = {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR};
+            break;
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+            candidates = {VK_PRESENT_MODE_FIFO_RELAXED_KHR};
+            break;
+        default:
+            break;
+        }
+
+        for (auto mode : candidates) {
+            if (supportPresentMode(mode)) {
                 return mode;
             }
         }
 
+        // FIFO is the only mode the spec guarantees
         return VK_PRESENT_MODE_FIFO_KHR;
     }
 
+    uint32_t chooseImageCount(VkPresentModeKHR presentMode) const {
+        uint32_t count = capabilities_.minImageCount;
+        switch (presentMode) {
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+            // one image on screen, one queued, one being rendered
+            count = std::max(count + 1, 3u);
+            break;
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+            // nothing is queued, extra images would only add memory
+            break;
+        default:
+            count = count + 1;
+            break;
+        }
+
+        if (capabilities_.maxImageCount > 0) {
+            count = std::min(count, capabilities_.maxImageCount);
+        }
+
+        return count;
+    }
+
     static SwapChainSupportDetail querySwapChainSupport(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) {
         SwapChainSupportDetail detail;
 
@@ -139,11 +187,13 @@ struct SwapChainSupportDetail {
     }
 };
 
-static std::vector<const char*> getRequiredExtensions() {
-    uint32_t count = 0;
-    auto extensions = glfwGetRequiredInstanceExtensions(&count);
-
-    std::vector<const char*> requiredExtensions(extensions, extensions + count);
+static std::vector<const char*> getRequiredExtensions(bool headless = false) {
+    std::vector<const char*> requiredExtensions;
+    if (!headless) {
+        uint32_t count = 0;
+        auto extensions = glfwGetRequiredInstanceExtensions(&count);
+        requiredExtensions.assign(extensions, extensions + count);
+    }
     requiredExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     requiredExtensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
     requiredExtensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
@@ -197,6 +247,118 @@ static uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFil
     throw std::runtime_error("failed to find suitable memory type!");
 }
 
+// what a resource's memory is for; picks among the types that have the required flags
+enum class MemoryUsage {
+    Unknown,    // first type with the required flags
+    GpuOnly,    // filled once through staging, then only touched by the GPU
+    Upload,     // staging: written once by the CPU, read once by the GPU
+    Dynamic,    // rewritten by the CPU every few frames, read by the GPU every frame
+    Readback,   // written by the GPU, read by the CPU
+};
+
+// which subsystem owns a resource's memory, for accounting
+enum class MemoryTag {
+    Other,
+    Canvas,
+    Glyphs,
+    Staging,
+    Attachments,
+    Uniforms,
+    Storage,
+    Vertices,
+    Count,
+};
+
+static const char* memoryTagName(MemoryTag tag) {
+    switch (tag) {
+    case MemoryTag::Canvas:         return "canvas";
+    case MemoryTag::Glyphs:         return "glyphs";
+    case MemoryTag::Staging:        return "staging";
+    case MemoryTag::Attachments:    return "attachments";
+    case MemoryTag::Uniforms:       return "uniforms";
+    case MemoryTag::Storage:        return "storage";
+    case MemoryTag::Vertices:       return "vertices";
+    default:                        return "other";
+    }
+}
+
+static uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties, MemoryUsage usage) {
+    if (usage == MemoryUsage::Unknown) {
+        return findMemoryType(physicalDevice, typeFilter, properties);
+    }
+
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+    int best = -1;
+    int bestScore = std::numeric_limits<int>::min();
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        auto flags = memProperties.memoryTypes[i].propertyFlags;
+        if (!(typeFilter & 1 << i) || (flags & properties) != properties) {
+            continue;
+        }
+        if (flags & (VK_MEMORY_PROPERTY_PROTECTED_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)) {
+            continue;
+        }
+
+        bool device = flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        bool host = flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+        bool coherent = flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        bool cached = flags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+        int score = 0;
+        switch (usage) {
+        case MemoryUsage::GpuOnly:
+            // leave the host-visible device-local window to dynamic data
+            score = (device ? 8 : 0) - (host ? 2 : 0);
+            break;
+        case MemoryUsage::Upload:
+            if (!host) {
+                continue;
+            }
+            score = (coherent ? 4 : 0) - (device ? 2 : 0) - (cached ? 1 : 0);
+            break;
+        case MemoryUsage::Dynamic:
+            // resizable BAR first, then device-local behind a staging copy, then plain host memory;
+            // only coherent memory is written directly, see Buffer::hostVisible
+            score = (device ? 8 : 0) + (host && coherent ? 4 : 0);
+            break;
+        case MemoryUsage::Readback:
+            if (!host) {
+                continue;
+            }
+            score = (cached ? 4 : 0) + (coherent ? 2 : 0) - (device ? 1 : 0);
+            break;
+        default:
+            break;
+        }
+
+        if (score > bestScore) {
+            best = static_cast<int>(i);
+            bestScore = score;
+        }
+    }
+
+    if (best < 0) {
+        return findMemoryType(physicalDevice, typeFilter, properties);
+    }
+    return static_cast<uint32_t>(best);
+}
+
+static uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferred) {
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+    auto wanted = properties | preferred;
+    for (size_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        if ((typeFilter & 1 << i) && (memProperties.memoryTypes[i].propertyFlags & wanted) == wanted) {
+            return i;
+        }
+    }
+
+    return findMemoryType(physicalDevice, typeFilter, properties);
+}
+
 static void setImageLayout(
     VkCommandBuffer cmdBuffer, 
     VkImage image, 
@@ -223,6 +385,14 @@ static void setImageLayout(
         imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
         break;
 
+    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+        imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        break;
+
+    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+        imageMemoryBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        break;
+
     default:
         throw std::runtime_error("unknown old layout!");
     }
@@ -232,6 +402,10 @@ static void setImageLayout(
         imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
         break;
 
+    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+        imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        break;
+
     case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
         imageMemoryBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
         break; 
@@ -398,4 +572,47 @@ static std::string rmSpace(const std::string& str) {
     return rmBackSpace(rmFrontSpace(str));
 }
 
+static void appendUtf8(std::string& str, char32_t codepoint) {
+    if (codepoint < 0x80) {
+        str.push_back(static_cast<char>(codepoint));
+    } else if (codepoint < 0x800) {
+        str.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+        str.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else if (codepoint < 0x10000) {
+        str.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+        str.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        str.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else {
+        str.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+        str.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+        str.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        str.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+}
+
+// drops the last codepoint, not just its last byte
+static void popUtf8(std::string& str) {
+    while (!str.empty() && (static_cast<unsigned char>(str.back()) & 0xC0) == 0x80) {
+        str.pop_back();
+    }
+    if (!str.empty()) {
+        str.pop_back();
+    }
+}
+
+static std::u32string decodeUtf8(const std::string& str) {
+    std::u32string codepoints;
+    for (size_t i = 0; i < str.size();) {
+        auto lead = static_cast<unsigned char>(str[i]);
+        size_t length = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+        char32_t codepoint = length == 1 ? lead : lead & (0x7F >> length);
+        for (size_t j = 1; j < length && i + j < str.size(); j++) {
+            codepoint = (codepoint << 6) | (static_cast<unsigned char>(str[i + j]) & 0x3F);
+        }
+        codepoints.push_back(codepoint);
+        i += length;
+    }
+    return codepoints;
+}
+
 };
\ No newline at end of file
@@ -14,6 +14,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <utility>
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
@@ -28,6 +29,7 @@
 #include "DescriptorSetLayout.h"
 #include "RenderPass.h"
 #include "Pipeline.h"
+#include "ShaderModule.h"
 #include "Swapchain.h"
 #include "FrameBuffer.h"
 #include "CommandPool.h"
@@ -36,14 +38,40 @@
 #include "Sampler.h"
 #include "Camera.h"
 #include "Timer.h"
+#include "TimingHistogram.h"
 #include "Line.h"
 #include "Font.h"
+#include "Config.h"
+#include "QueryPool.h"
+#include "MemoryAllocator.h"
+#include "Profiler.h"
+#include "DeletionQueue.h"
+#include "AssetPack.h"
+#include "FontManager.h"
+#include "GlyphCache.h"
+#include "TextLayout.h"
+#include "TextRaster.h"
+#include "TiledImage.h"
 
 class Vulkan {
 public:
-    Vulkan(const std::string& title, uint32_t width, uint32_t height);
+    Vulkan(const std::string& title, uint32_t width, uint32_t height, const Config& config = Config());
 
     void run();
+
+    // headless only: RGBA8 pixels of the last rendered frame, row by row
+    std::vector<uint8_t> readback();
+    bool saveFrame(const std::string& path);
+
+    // interval between consecutive draws
+    const TimingHistogram& frameTimes() const { return frameTimes_; }
+    // from the cursor callback to the GPU finishing the frame that draws that sample
+    const TimingHistogram& inputLatency() const { return inputLatency_; }
+    // device memory handed back by defragmentation so far
+    VkDeviceSize reclaimedBytes() const { return reclaimedBytes_; }
+    // per-subsystem bytes and per-heap usage against the driver's budget
+    MemoryAllocator::Stats memoryStats() const { return allocator_->stats(); }
+    void logMemory() const;
 private:
     void initWindow();
     void initVulkan();
@@ -53,9 +81,11 @@ private:
     void createSurface();
     void pickPhysicalDevice();
     void createLogicDevice();
-    void createSwapChain();
+    void createAllocator();
+    void createSwapChain(VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE);
     void createRenderPass();
     void createUniformBuffers();
+    void createCanvasUniformBuffer();
     void createSamplers();
     void createDescriptorPool();
     void createDescriptorSetLayout();
@@ -70,11 +100,22 @@ private:
     void createVertexBuffer();
     void createIndexBuffer();
     void createSyncObjects();
+    void createQueryPool();
     void recordCommadBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
     void draw();
     void loadAssets();
+    // from the asset pack when it has it, else from shaders/spv
+    ShaderModule loadShader(const std::string& name);
     void updateDrawAssets();
     void recreateSwapChain();
+    VkPresentModeKHR preferredPresentMode() const;
+    uint64_t frameBudget() const;
+    void beginTimestamps(VkCommandBuffer commandBuffer);
+    void writeTimestamp(VkCommandBuffer commandBuffer, uint32_t query);
+    void collectTimestamps();
+    void defragment();
+    std::unique_ptr<Buffer> relocated(const Buffer& buffer, VkCommandBuffer commandBuffer);
+    std::unique_ptr<Image> relocated(const Image& image, VkCommandBuffer commandBuffer);
 
 private:
     bool checkValidationLayerSupport() ;
@@ -82,15 +123,21 @@ private:
     bool deviceSuitable(VkPhysicalDevice);
     void loadTextures();
     void loadChars();
+    void stageGlyphUploads();
+    void recordGlyphUploads(VkCommandBuffer commandBuffer);
+    void reserveTextGlyphs(uint32_t glyphs);
     VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
-    VkSampleCountFlagBits getMaxUsableSampleCount();
+    VkSampleCountFlagBits chooseSampleCount(VkSampleCountFlagBits requested);
+    bool multisampled() const { return msaaSamples_ != VK_SAMPLE_COUNT_1_BIT; }
     VkFormat findDepthFormat();
     VkFormat findSupportedFormat(const std::vector<VkFormat>& formats, VkImageTiling tiling, VkFormatFeatureFlags features);
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
-    void copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size);
+    void upload(Buffer& buffer, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
+    void recordBufferUploads(VkCommandBuffer commandBuffer);
     VkCommandBuffer beginSingleTimeCommands();
     void endSingleTimeCommands(VkCommandBuffer commandBuffer, VkQueue queue);
-    void fillColor(uint32_t index);
+    // edge is how far inside the stroke the pixel is, in pixels
+    void fillColor(uint32_t index, float edge);
 
     void createBrushPipeline();
     void createCanvasPipeline();
@@ -108,20 +155,40 @@ private:
     void createTextDescriptorSet();
     void createCanvasDescriptorSet();
 
+    void writeBrushDescriptorSet();
+    void writeTextDescriptorSet();
+    void writeCanvasDescriptorSet();
+
     void changePoint();
     bool validPoint(int x, int y);
 
     void processText();
-    void updateTexture();
+    struct TextBlock;
+    void commitText(const std::string& text);
+    void stampText(const TextBlock& block);
+    static std::unique_ptr<TiledImage> decodeCanvasTiles(const std::string& path, const AssetPack* pack, uint32_t tileSize, uint32_t slots, uint32_t maxExtent);
+    uint32_t canvasTileSlots() const;
+    uint32_t canvasMaxExtent() const;
+    std::vector<TiledImage::Upload> showCanvas(TiledImage& tiles) const;
+    std::unique_ptr<Image> createCanvasImage(uint32_t slots);
+    std::unique_ptr<Buffer> createTileTable(const TiledImage& tiles);
+    void writeTileTable(Buffer& buffer, const TiledImage& tiles);
+    std::unique_ptr<Buffer> stageTiles(const std::vector<TiledImage::Upload>& uploads, std::vector<VkBufferImageCopy>& regions);
+    void loadTexture(const std::string& path);
+    void pollTextureLoad();
+    void recordTextureLoad(VkCommandBuffer commandBuffer);
+    void updateCanvasTiles();
+    void recordTileUploads(VkCommandBuffer commandBuffer);
     
-    GLFWwindow* windows_;
+    GLFWwindow* windows_ = nullptr;
     uint32_t width_;
     uint32_t height_;
     std::string title_;
+    Config config_;
 
     VkInstance instance_;
     VkDebugUtilsMessengerEXT debugMessenger_;
-    VkSurfaceKHR surface_;
+    VkSurfaceKHR surface_ = VK_NULL_HANDLE;
     VkPhysicalDevice physicalDevice_ = VK_NULL_HANDLE;
     VkDevice device_;
     std::unique_ptr<RenderPass> renderPass_;
@@ -129,11 +196,21 @@ private:
     VkQueue presentQueue_;
     VkQueue transferQueue_;
 
+    // declared ahead of every Buffer and Image so it is destroyed after them
+    std::unique_ptr<MemoryAllocator> allocator_;
+    // defragmentation waits for this many frames without input, then moves at most budget bytes per frame
+    uint32_t idleFrames_ = 0;
+    const uint32_t defragmentIdleFrames_ = 120;
+    const VkDeviceSize defragmentBudget_ = 16ull << 20;
+    VkDeviceSize defragmentMoved_ = 0;
+    VkDeviceSize reclaimedBytes_ = 0;
+    // host allocations made while initializing, so the per-frame rate only counts the frames
+    uint64_t hostAllocationsAfterInit_ = 0;
+
     std::function<void(VkImage*)> vkImageDelete;
 
     std::unique_ptr<SwapChain> swapChain_;
 
-    std::unique_ptr<Sampler> brushSampler_;
     std::unique_ptr<Sampler> canvasSampler_;
 
     std::unique_ptr<DescriptorPool> brushDescriptorPool_;
@@ -163,25 +240,85 @@ private:
     std::unique_ptr<Semaphore> imageAvaiableSemaphores_;
     std::unique_ptr<Semaphore> renderFinishSemaphores_;
 
+    // GPU pass boundaries of the frame in flight, only written with ENABLE_PROFILER
+    enum TimestampQuery : uint32_t {
+        FrameBegin,
+        UploadsEnd,
+        LinesEnd,
+        TextEnd,
+        CanvasEnd,
+        TimestampQueryCount,
+    };
+    std::unique_ptr<QueryPool> timestampQueryPool_;
+    float timestampPeriod_ = 0.0f;
+    uint64_t timestampMask_ = 0;
+    bool timestampsPending_ = false;
+    uint64_t submitTime_ = 0;
+
     std::string skyBoxPath_ = "../textures/skybox.ktx";
     ktxTexture* skyBoxTexture_;
     std::unique_ptr<Image> skyBoxImage_;
 
-    std::string canvasTexturePath_ = "../textures/canvas-texture1.jpg";
-    std::string updateCanvasTexturePath_;
+    // mapped for the whole run, its views are read from whenever an asset is loaded
+    std::unique_ptr<AssetPack> assetPack_;
+    // the canvas texture's tiles on the host, the slots holding the resident ones and the table
+    // Canvas.frag finds them through
+    std::unique_ptr<TiledImage> canvasTiles_;
     std::unique_ptr<Image> canvasImage_;
+    std::unique_ptr<Buffer> canvasTileTable_;
+    // set when the swapchain size changes, the next frame picks the level and tiles again
+    bool canvasViewChanged_ = false;
+    std::unique_ptr<Buffer> tileStaging_;
+    std::vector<VkBufferImageCopy> tileRegions_;
+
+    // :load: decodes and slices on a worker thread and uploads on the transfer queue while frames
+    // keep going; the canvas is swapped for the new one once the upload fence has signaled
+    struct DecodedImage {
+        std::string path_;
+        // null when the file couldn't be read
+        std::unique_ptr<TiledImage> tiles_;
+    };
+    // declared after assetPack_: destroying the future waits for the worker reading from it
+    std::future<DecodedImage> textureDecode_;
+    // one load at a time, the latest request waits here
+    std::string queuedTexturePath_;
+    std::unique_ptr<CommandPool> transferCommandPool_;
+    std::unique_ptr<CommandBuffer> textureUploadCommands_;
+    std::unique_ptr<Fence> textureUploadFence_;
+    std::unique_ptr<Semaphore> textureUploadSemaphore_;
+    std::unique_ptr<Buffer> textureStaging_;
+    std::unique_ptr<TiledImage> uploadingTiles_;
+    std::unique_ptr<Image> uploadingImage_;
+    std::unique_ptr<Buffer> uploadingTileTable_;
+    // the next frame waits for the upload and moves canvasImage_ to SHADER_READ_ONLY
+    bool textureUploaded_ = false;
     bool updateCanvas_ = false;
 
     Tools::QueueFamilyIndices queueFamilies_;
     VkSampleCountFlagBits msaaSamples_ = VK_SAMPLE_COUNT_1_BIT;
 
     const std::vector<const char*> validationLayers_ = {"VK_LAYER_KHRONOS_validation"};
-    const std::vector<const char*> deviceExtensions_ = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    std::vector<const char*> deviceExtensions_ = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    // optional, enabled when the device has it
+    bool memoryBudget_ = false;
 
     std::unique_ptr<Buffer> uniformBuffers_;
+    // staged copies into buffers the CPU can't map, recorded at the start of the next frame
+    struct BufferUpload {
+        std::unique_ptr<Buffer> staging_;
+        VkBuffer buffer_ = VK_NULL_HANDLE;
+        VkBufferCopy region_{};
+    };
+    std::vector<BufferUpload> bufferUploads_;
 
     std::shared_ptr<Camera> camera_;
     Timer timer_;
+    TimingHistogram frameTimes_;
+    TimingHistogram inputLatency_;
+    // cursor samples not drawn yet, and those riding on frame inFlightInputFrame_
+    std::vector<uint64_t> pendingInputTimes_;
+    std::vector<uint64_t> inFlightInputTimes_;
+    uint64_t inFlightInputFrame_ = 0;
 
     struct Character {
         Character() {}
@@ -200,6 +337,17 @@ private:
 
     bool resized_ = false;
 
+    // frames submitted so far, and how many of them the GPU has finished
+    uint64_t frameIndex_ = 0;
+    uint64_t completedFrame_ = 0;
+    // headless: which offscreen image the last frame went to
+    uint32_t renderedImage_ = 0;
+
+    // replaced objects wait here until the frames submitted before the replacement have completed
+    DeletionQueue deletionQueue_;
+    template<typename T>
+    void retire(T&& resource) { deletionQueue_.retire(frameIndex_, std::move(resource)); }
+
     static void frameBufferResizedCallback(GLFWwindow* window, int width, int height) {
         auto app = reinterpret_cast<Vulkan*>(glfwGetWindowUserPointer(window));
         app->resized_ = true;
@@ -218,6 +366,9 @@ private:
     std::unique_ptr<Buffer> lineVertexBuffers_;
     std::unique_ptr<Buffer> lineIndexBuffers_;
     std::vector<uint32_t> lineVertexMaps_;
+    // vertices changed since the last upload
+    uint32_t lineDirtyBegin_ = UINT32_MAX;
+    uint32_t lineDirtyEnd_ = 0;
     float lineWidth_ = 1.0f;
     bool LeftButton_ = false;
     bool LeftButtonOnce_ = false;
@@ -232,23 +383,44 @@ private:
     
     int times_ = 0;
 
+    // declared before everything holding its faces, so it is destroyed after them
+    FontManager fontManager_;
     std::unique_ptr<Font> font_;
-    const std::string fontPath_ = "../fonts/jbMono.ttf";
-    std::unordered_map<char, Font::Character> dictionary_;
+    float fontSize_ = 32.0f;
+    // every glyph's bitmap, packed into one R8 texture that text samples through a single descriptor;
+    // the cache itself is owned by fontManager_
+    GlyphCache* glyphCache_ = nullptr;
+    std::unique_ptr<Image> glyphAtlasImage_;
+    // atlas regions changed while building this frame's text, copied in before the render pass
+    std::unique_ptr<Buffer> glyphStaging_;
+    std::vector<VkBufferImageCopy> glyphRegions_;
     std::unique_ptr<PipelineLayout> fontPipelineLayout_;
     std::unique_ptr<Pipeline> fontPipeline_;
     std::unique_ptr<DescriptorPool> fontDescriptorPool_;
     std::unique_ptr<DescriptorSetLayout> fontDescriptorSetLayout_;
     VkDescriptorSet fontDescriptorSet_;
-    std::vector<Font::Point> fontVertices_;
-    std::vector<uint32_t> fontIndices_;
+    // the input line, laid out incrementally into a persistently mapped instance buffer that only grows
+    TextLayout textLayout_;
+    // what textLayout_ was last laid out from; cleared to lay it out again
+    std::string laidOutText_;
+    uint64_t lastEvictions_ = 0;
+    uint32_t fontGlyphCapacity_ = 0;
     std::unique_ptr<Buffer> fontVertexBuffer_;
-    std::unique_ptr<Buffer> fontIndexBuffer_;
 
     int inputText_ = 0;
-    int capsLock_ = 0;
     std::string text_;
 
+    // text committed into the ink; the pixels are stamped once, the layout stays for re-editing
+    // and for stamping again when the ink is rebuilt
+    struct TextBlock {
+        std::u32string text_;
+        // pen at the start of the baseline, in ink coordinates
+        glm::vec2 origin_{};
+        float size_ = 0.0f;
+        glm::vec3 color_{};
+    };
+    std::vector<TextBlock> textBlocks_;
+
     enum Color {
         Write, 
         Red, 
@@ -1,6 +1,13 @@
 #version 450
 
-layout(set = 0, binding = 1) uniform sampler2D texSampler; 
+// the canvas image is tiled, see TiledImage: every resident tile is one layer
+layout(set = 0, binding = 1) uniform sampler2DArray tiles;
+
+layout(std430, set = 0, binding = 2) readonly buffer TileTable {
+    uvec4 grid;     // columns, rows, level width, level height
+    uvec4 tile;     // tile size, stride, gutter
+    uint layers[];  // per tile of the level, 0xffffffff when not resident
+} table;
 
 layout(location = 0) in struct {
     vec3 color;
@@ -10,5 +17,14 @@ layout(location = 0) in struct {
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = texture(texSampler, outValue.texCoord);
-}
\ No newline at end of file
+    vec2 texel = outValue.texCoord * vec2(table.grid.zw);
+    uvec2 cell = min(uvec2(texel) / table.tile.y, table.grid.xy - 1u);
+    uint layer = table.layers[cell.y * table.grid.x + cell.x];
+    if (layer == 0xffffffffu) {
+        outColor = vec4(0.0);
+        return;
+    }
+    vec2 local = (texel - vec2(cell * table.tile.y) + float(table.tile.z)) / float(table.tile.x);
+    // the level is picked on the CPU, and derivatives jump at tile edges
+    outColor = textureLod(tiles, vec3(local, float(layer)), 0.0);
+}
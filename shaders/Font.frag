@@ -1,17 +1,17 @@
 #version 450
 
-layout(set = 0, binding = 1) uniform sampler2D fontSampler[26];
+layout(set = 0, binding = 1) uniform sampler2D fontSampler;
 
 layout(location = 0) in struct {
     vec3 color;
     vec2 texCoord;
 } outValue;
 
-flat layout(location = 2) in uint index;
-
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = vec4(outValue.color, 0.0);
-    outColor.a = texture(fontSampler[index], outValue.texCoord).r;
+    // signed distance field: 0.5 on the outline, antialiased over about one screen pixel at any scale
+    float distance = texture(fontSampler, outValue.texCoord).r;
+    float width = max(fwidth(distance), 1e-4);
+    outColor = vec4(outValue.color, smoothstep(0.5 - width, 0.5 + width, distance));
 }
\ No newline at end of file
@@ -6,21 +6,27 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
     mat4 proj;
 } ubo;
 
+// one Font::Glyph per instance
 layout(location = 0) in vec2 inPosition;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 inTexCoord;
-layout(location = 3) in uint inIndex;
+layout(location = 1) in vec2 inSize;
+layout(location = 2) in vec4 inUvRect;
+layout(location = 3) in vec4 inColor;
 
 layout(location = 0) out struct {
     vec3 color;
     vec2 texCoord;
 } outValue;
 
-layout(location = 2) out uint outIndex;
+// two triangles, in the winding Plane::vertices uses
+const vec2 corners[6] = vec2[](
+    vec2(0.0, 1.0), vec2(1.0, 1.0), vec2(0.0, 0.0),
+    vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(1.0, 0.0)
+);
 
 void main() {
-    gl_Position = ubo.proj * vec4(inPosition, 0.0, 1.0);
-    outValue.color = inColor;
-    outValue.texCoord = inTexCoord;
-    outIndex = inIndex;
-}
\ No newline at end of file
+    vec2 corner = corners[gl_VertexIndex];
+    gl_Position = ubo.proj * vec4(inPosition + corner * inSize, 0.0, 1.0);
+    outValue.color = inColor.rgb;
+    // bitmaps are stored top row first
+    outValue.texCoord = mix(inUvRect.xy, inUvRect.zw, vec2(corner.x, 1.0 - corner.y));
+}
@@ -1,7 +1,5 @@
 #version 450
 
-layout(set = 0, binding = 1) uniform sampler2D texSampler; 
-
 layout(location = 0) in struct {
     vec4 color;
     vec2 texCoord;
@@ -10,5 +8,9 @@ layout(location = 0) in struct {
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = outValue.color;
+    // every point is one pixel, so its distance to the stroke's edge is already in pixels and
+    // fwidth would be 0; a pixel centred on the edge is half covered. The canvas is blended under
+    // the ink by its alpha, which makes this the edge antialiasing at 1x.
+    float coverage = clamp(outValue.texCoord.x + 0.5, 0.0, 1.0);
+    outColor = vec4(outValue.color.rgb, outValue.color.a * coverage);
 }
\ No newline at end of file
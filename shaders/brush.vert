@@ -8,7 +8,8 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
 
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec4 inColor;
-layout(location = 2) in vec2 inWidthAndHeight;
+// x: how far inside the stroke this pixel is, see Line::inside_
+layout(location = 2) in vec2 inEdge;
 
 layout(location = 0) out struct {
     vec4 color;
@@ -19,4 +20,5 @@ void main() {
     gl_Position =  ubo.proj * vec4(inPosition, 0.0, 1.0);
     gl_PointSize = 1.0;
     outValue.color = inColor;
+    outValue.texCoord = inEdge;
 }
\ No newline at end of file
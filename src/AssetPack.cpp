@@ -0,0 +1,180 @@
+#include "AssetPack.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+AssetPack::AssetPack(const std::string& path) {
+#ifdef _WIN32
+    auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("failed to open asset pack " + path);
+    }
+    file_ = file;
+    LARGE_INTEGER size{};
+    GetFileSizeEx(file, &size);
+    size_ = static_cast<size_t>(size.QuadPart);
+    if (size_ != 0) {
+        mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_) {
+            data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        }
+    }
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        throw std::runtime_error("failed to open asset pack " + path);
+    }
+    struct stat info{};
+    fstat(file, &info);
+    size_ = static_cast<size_t>(info.st_size);
+    if (size_ != 0) {
+        auto data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+        data_ = data == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(data);
+    }
+    // the mapping keeps the file alive
+    close(file);
+#endif
+    if (!data_) {
+        unmap();
+        throw std::runtime_error("failed to map asset pack " + path);
+    }
+
+    Header header;
+    if (size_ < sizeof(header)) {
+        unmap();
+        throw std::runtime_error("asset pack " + path + " is truncated");
+    }
+    std::memcpy(&header, data_, sizeof(header));
+    if (header.magic_ != magic_ || header.version_ != version_) {
+        unmap();
+        throw std::runtime_error("asset pack " + path + " is not a version " + std::to_string(version_) + " pack");
+    }
+    if (sizeof(Header) + static_cast<uint64_t>(header.count_) * sizeof(Entry) > size_) {
+        unmap();
+        throw std::runtime_error("asset pack " + path + " is truncated");
+    }
+
+    entries_ = reinterpret_cast<const Entry*>(data_ + sizeof(Header));
+    count_ = header.count_;
+    for (uint32_t i = 0; i < count_; i++) {
+        if (entries_[i].offset_ > size_ || entries_[i].size_ > size_ - entries_[i].offset_) {
+            unmap();
+            throw std::runtime_error("asset pack " + path + " is truncated");
+        }
+    }
+}
+
+AssetPack::~AssetPack() {
+    unmap();
+}
+
+void AssetPack::unmap() {
+#ifdef _WIN32
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+    }
+    if (file_) {
+        CloseHandle(file_);
+    }
+    file_ = mapping_ = nullptr;
+#else
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    entries_ = nullptr;
+    count_ = 0;
+}
+
+bool AssetPack::stamp(const std::string& path, uint64_t& size, int64_t& time) {
+    std::error_code error;
+    size = std::filesystem::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    // only ever compared with what a build of the same bake tool wrote
+    time = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+    return !error;
+}
+
+std::optional<AssetPack::View> AssetPack::find(const std::string& name, const std::string& source) const {
+    // a handful of entries, a linear scan is all it takes
+    for (uint32_t i = 0; i < count_; i++) {
+        const auto& entry = entries_[i];
+        if (strncmp(entry.name_, name.c_str(), sizeof(entry.name_)) != 0) {
+            continue;
+        }
+        uint64_t size;
+        int64_t time;
+        if (!source.empty() && stamp(source, size, time) && (size != entry.sourceSize_ || time != entry.sourceTime_)) {
+            return std::nullopt;
+        }
+        return View{data_ + entry.offset_, static_cast<size_t>(entry.size_), entry.width_, entry.height_};
+    }
+    return std::nullopt;
+}
+
+void AssetPack::Writer::add(const std::string& name, const void* data, size_t size, uint32_t width, uint32_t height, const std::string& source) {
+    Entry entry;
+    if (name.size() >= sizeof(entry.name_)) {
+        throw std::runtime_error("asset name too long: " + name);
+    }
+    std::memcpy(entry.name_, name.c_str(), name.size());
+    entry.size_ = size;
+    entry.width_ = width;
+    entry.height_ = height;
+    if (!source.empty() && !stamp(source, entry.sourceSize_, entry.sourceTime_)) {
+        throw std::runtime_error("failed to read " + source);
+    }
+    entries_.push_back(entry);
+
+    auto bytes = static_cast<const uint8_t*>(data);
+    data_.emplace_back(bytes, bytes + size);
+}
+
+void AssetPack::Writer::write(const std::string& path) const {
+    auto align = [](uint64_t offset) { return (offset + alignment_ - 1) / alignment_ * alignment_; };
+
+    Header header;
+    header.count_ = static_cast<uint32_t>(entries_.size());
+    auto entries = entries_;
+    uint64_t offset = align(sizeof(Header) + sizeof(Entry) * entries.size());
+    for (auto& entry : entries) {
+        entry.offset_ = offset;
+        offset = align(offset + entry.size_);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to write asset pack " + path);
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), sizeof(Entry) * entries.size());
+    uint64_t position = sizeof(Header) + sizeof(Entry) * entries.size();
+    const char zeros[alignment_]{};
+    for (size_t i = 0; i < entries.size(); i++) {
+        file.write(zeros, static_cast<std::streamsize>(entries[i].offset_ - position));
+        file.write(reinterpret_cast<const char*>(data_[i].data()), static_cast<std::streamsize>(data_[i].size()));
+        position = entries[i].offset_ + data_[i].size();
+    }
+    if (!file) {
+        throw std::runtime_error("failed to write asset pack " + path);
+    }
+}
@@ -0,0 +1,75 @@
+#include "BuddyAllocator.h"
+#include <algorithm>
+#include <stdexcept>
+
+BuddyAllocator::BuddyAllocator(uint64_t size, uint64_t minSize) : size_(size), minSize_(minSize) {
+    if (minSize_ == 0 || (minSize_ & (minSize_ - 1)) || size_ < minSize_ || (size_ & (size_ - 1))) {
+        throw std::runtime_error("buddy allocator sizes must be powers of two!");
+    }
+
+    while ((minSize_ << maxOrder_) < size_) {
+        maxOrder_++;
+    }
+    free_.resize(maxOrder_ + 1);
+    free_[maxOrder_].insert(0);
+}
+
+uint32_t BuddyAllocator::orderFor(uint64_t size) const {
+    uint32_t order = 0;
+    while ((minSize_ << order) < size) {
+        order++;
+    }
+    return order;
+}
+
+bool BuddyAllocator::allocate(uint64_t size, uint64_t alignment, uint64_t& offset, uint32_t& order) {
+    auto need = std::max(size, alignment);
+    if (need > size_) {
+        return false;
+    }
+    order = orderFor(need);
+
+    auto current = order;
+    while (current <= maxOrder_ && free_[current].empty()) {
+        current++;
+    }
+    if (current > maxOrder_) {
+        return false;
+    }
+
+    offset = *free_[current].begin();
+    free_[current].erase(free_[current].begin());
+    // split, handing the upper halves back
+    while (current > order) {
+        current--;
+        free_[current].insert(offset + blockSize(current));
+    }
+
+    used_ += blockSize(order);
+    return true;
+}
+
+void BuddyAllocator::free(uint64_t offset, uint32_t order) {
+    used_ -= blockSize(order);
+
+    while (order < maxOrder_) {
+        auto buddy = offset ^ blockSize(order);
+        auto it = free_[order].find(buddy);
+        if (it == free_[order].end()) {
+            break;
+        }
+        free_[order].erase(it);
+        offset = std::min(offset, buddy);
+        order++;
+    }
+    free_[order].insert(offset);
+}
+
+uint64_t BuddyAllocator::largestFree() const {
+    for (uint32_t order = maxOrder_ + 1; order-- > 0;) {
+        if (!free_[order].empty()) {
+            return blockSize(order);
+        }
+    }
+    return 0;
+}
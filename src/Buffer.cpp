@@ -1,13 +1,18 @@
 #include "Buffer.h"
 #include "vulkan/vulkan_core.h"
 #include "Tools.h"
+#include "HostAllocator.h"
 
-Buffer::Buffer(VkPhysicalDevice physicalDevice, VkDevice device) : physicalDevice_(physicalDevice), device_(device) {
+Buffer::Buffer(VkPhysicalDevice physicalDevice, VkDevice device, MemoryAllocator* allocator) : physicalDevice_(physicalDevice), device_(device), allocator_(allocator) {
 }
 
 Buffer::~Buffer() {
-    vkDestroyBuffer(device_, buffer_, nullptr);
-    vkFreeMemory(device_, memory_, nullptr);
+    vkDestroyBuffer(device_, buffer_, HostAllocator::callbacks(HostAllocator::ObjectType::Buffer));
+    if (allocator_) {
+        allocator_->free(allocation_);
+    } else {
+        vkFreeMemory(device_, memory_, HostAllocator::callbacks(HostAllocator::ObjectType::Memory));
+    }
 }
 
 void Buffer::init() {
@@ -22,15 +27,37 @@ void Buffer::init() {
     bufferInfo.pQueueFamilyIndices = pQueueFamilyIndices_;
     bufferInfo.sharingMode = sharingMode_;
 
-    VK_CHECK(vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer_));
+    VK_CHECK(vkCreateBuffer(device_, &bufferInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Buffer), &buffer_));
+
+    if (allocator_) {
+        VkMemoryDedicatedRequirements dedicatedRequirements{};
+        dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+        VkMemoryRequirements2 requirements2{};
+        requirements2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+        requirements2.pNext = &dedicatedRequirements;
+        VkBufferMemoryRequirementsInfo2 requirementsInfo{};
+        requirementsInfo.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+        requirementsInfo.buffer = buffer_;
+        vkGetBufferMemoryRequirements2(device_, &requirementsInfo, &requirements2);
+
+        auto dedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+        allocation_ = allocator_->allocate(requirements2.memoryRequirements, memoryProperties_, 0, memoryUsage_, memoryTag_, MemoryAllocator::Kind::Linear, dedicated, VK_NULL_HANDLE, buffer_);
+        memory_ = allocation_.memory_;
+        memoryFlags_ = allocation_.flags_;
+        VK_CHECK(vkBindBufferMemory(device_, buffer_, memory_, allocation_.offset_));
+        return ;
+    }
 
     vkGetBufferMemoryRequirements(device_, buffer_, &memRequirements);
-
     memoryInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     memoryInfo.allocationSize = memRequirements.size;
-    memoryInfo.memoryTypeIndex = Tools::findMemoryType(physicalDevice_, memRequirements.memoryTypeBits, memoryProperties_);
+    memoryInfo.memoryTypeIndex = Tools::findMemoryType(physicalDevice_, memRequirements.memoryTypeBits, memoryProperties_, memoryUsage_);
+
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &memProperties);
+    memoryFlags_ = memProperties.memoryTypes[memoryInfo.memoryTypeIndex].propertyFlags;
 
-    VK_CHECK(vkAllocateMemory(device_, &memoryInfo, nullptr, &memory_));
+    VK_CHECK(vkAllocateMemory(device_, &memoryInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Memory), &memory_));
 
     VK_CHECK(vkBindBufferMemory(device_, buffer_, memory_, 0));
 }
\ No newline at end of file
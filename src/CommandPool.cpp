@@ -1,13 +1,14 @@
 #include "CommandPool.h"
 #include "vulkan/vulkan_core.h"
 #include "Tools.h"
+#include "HostAllocator.h"
 
 CommandPool::CommandPool(VkDevice device) : device_(device) {
     
 }
 
 CommandPool::~CommandPool() {
-    vkDestroyCommandPool(device_, commandPool_, nullptr);
+    vkDestroyCommandPool(device_, commandPool_, HostAllocator::callbacks(HostAllocator::ObjectType::Command));
 }
 
 void CommandPool::init() {
@@ -16,5 +17,5 @@ void CommandPool::init() {
     commandPoolInfo.flags = flags_;
     commandPoolInfo.pNext = pNext_;
     commandPoolInfo.queueFamilyIndex = queueFamilyIndex_;
-    VK_CHECK(vkCreateCommandPool(device_, &commandPoolInfo, nullptr, &commandPool_));
+    VK_CHECK(vkCreateCommandPool(device_, &commandPoolInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Command), &commandPool_));
 }
\ No newline at end of file
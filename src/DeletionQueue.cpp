@@ -0,0 +1,34 @@
+#include "DeletionQueue.h"
+
+DeletionQueue::~DeletionQueue() {
+    flush();
+}
+
+void DeletionQueue::retire(uint64_t frame, std::function<void()> destroy) {
+    if (destroy) {
+        push(frame, nullptr, std::move(destroy));
+    }
+}
+
+void DeletionQueue::push(uint64_t frame, std::shared_ptr<void> resource, std::function<void()> destroy) {
+    Entry entry;
+    entry.frame_ = frame;
+    entry.resource_ = std::move(resource);
+    entry.destroy_ = std::move(destroy);
+    entries_.push_back(std::move(entry));
+}
+
+void DeletionQueue::collect(uint64_t completedFrame) {
+    // frames only grow, so the entries are ordered and the ready ones sit at the front
+    while (!entries_.empty() && entries_.front().frame_ <= completedFrame) {
+        auto entry = std::move(entries_.front());
+        entries_.pop_front();
+        if (entry.destroy_) {
+            entry.destroy_();
+        }
+    }
+}
+
+void DeletionQueue::flush() {
+    collect(UINT64_MAX);
+}
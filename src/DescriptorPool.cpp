@@ -1,13 +1,14 @@
 #include "DescriptorPool.h"
 #include "vulkan/vulkan_core.h"
 #include "Tools.h"
+#include "HostAllocator.h"
 
 DescriptorPool::DescriptorPool(VkDevice device) : device_(device) {
 
 }
 
 DescriptorPool::~DescriptorPool() {
-    vkDestroyDescriptorPool(device_, descriptorPool_, nullptr);
+    vkDestroyDescriptorPool(device_, descriptorPool_, HostAllocator::callbacks(HostAllocator::ObjectType::Descriptor));
 }
 
 void DescriptorPool::init() {
@@ -18,5 +19,5 @@ void DescriptorPool::init() {
     descriptorPoolInfo.maxSets = maxSets_;
     descriptorPoolInfo.poolSizeCount = poolSizeCount_;
     descriptorPoolInfo.pPoolSizes = pPoolSizes_;
-    VK_CHECK(vkCreateDescriptorPool(device_, &descriptorPoolInfo, nullptr, &descriptorPool_));
+    VK_CHECK(vkCreateDescriptorPool(device_, &descriptorPoolInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Descriptor), &descriptorPool_));
 }
\ No newline at end of file
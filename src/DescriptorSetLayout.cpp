@@ -1,13 +1,14 @@
 #include "DescriptorSetLayout.h"
 #include "vulkan/vulkan_core.h"
 #include "Tools.h"
+#include "HostAllocator.h"
 
 DescriptorSetLayout::DescriptorSetLayout(VkDevice device) : device_(device) {
 
 }
 
 DescriptorSetLayout::~DescriptorSetLayout() {
-    vkDestroyDescriptorSetLayout(device_, descriptorSetlayout_, nullptr);
+    vkDestroyDescriptorSetLayout(device_, descriptorSetlayout_, HostAllocator::callbacks(HostAllocator::ObjectType::Descriptor));
 }
 
 void DescriptorSetLayout::init() {
@@ -17,5 +18,5 @@ void DescriptorSetLayout::init() {
     descriptorSetLayoutInfo.pNext = pNext_;
     descriptorSetLayoutInfo.bindingCount = bindingCount_;
     descriptorSetLayoutInfo.pBindings = pBindings_;
-    VK_CHECK(vkCreateDescriptorSetLayout(device_, &descriptorSetLayoutInfo, nullptr, &descriptorSetlayout_));
+    VK_CHECK(vkCreateDescriptorSetLayout(device_, &descriptorSetLayoutInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Descriptor), &descriptorSetlayout_));
 }
\ No newline at end of file
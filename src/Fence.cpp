@@ -1,13 +1,14 @@
 #include "Fence.h"
 #include "vulkan/vulkan_core.h"
 #include "Tools.h"
+#include "HostAllocator.h"
 
 Fence::Fence(VkDevice device) : device_(device) {
 
 }
 
 Fence::~Fence() {
-    vkDestroyFence(device_, fence_, nullptr);
+    vkDestroyFence(device_, fence_, HostAllocator::callbacks(HostAllocator::ObjectType::Sync));
 }
 
 void Fence::init() {
@@ -15,5 +16,5 @@ void Fence::init() {
     fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fenceInfo.flags = flags_;
     fenceInfo.pNext = pNext_;
-    VK_CHECK(vkCreateFence(device_, &fenceInfo, nullptr, &fence_));
+    VK_CHECK(vkCreateFence(device_, &fenceInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Sync), &fence_));
 }
\ No newline at end of file
@@ -1,9 +1,15 @@
 #include "Font.h"
 #include "freetype/freetype.h"
 #include "freetype/fttypes.h"
+#include "freetype/ftmodapi.h"
+#include "freetype/ftsizes.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <exception>
 #include <stdexcept>
+#include <thread>
 
 Font::Font(const std::string& path, uint32_t size) {
     check(FT_Init_FreeType(&libarry_));
@@ -13,12 +19,96 @@ Font::Font(const std::string& path, uint32_t size) {
     check(FT_Set_Pixel_Sizes(face_, 0, size));
 }
 
+Font::Font(FT_Library library, FT_Face face, uint32_t size) : libarry_(library), face_(face), ownsFace_(false) {
+    check(FT_New_Size(face_, &size_));
+    activate();
+    check(FT_Set_Pixel_Sizes(face_, 0, size));
+}
+
+Font::~Font() {
+    if (!ownsFace_) {
+        FT_Done_Size(size_);
+        return ;
+    }
+    FT_Done_Face(face_);
+    FT_Done_FreeType(libarry_);
+}
+
+void Font::activate() {
+    if (size_) {
+        check(FT_Activate_Size(size_));
+    }
+}
+
 void Font::loadChar(char c) {
+    activate();
     if (FT_Load_Char(face_, c, FT_LOAD_RENDER)) {
         throw std::runtime_error("faield to load char");
     }
 }
 
+Font::Bitmap Font::renderSdf(uint32_t codepoint, uint32_t spread) {
+    FT_Int value = static_cast<FT_Int>(spread);
+    // outlines go through "sdf", glyphs that only come as bitmaps through "bsdf"
+    check(FT_Property_Set(libarry_, "sdf", "spread", &value));
+    check(FT_Property_Set(libarry_, "bsdf", "spread", &value));
+    activate();
+    check(FT_Load_Char(face_, codepoint, FT_LOAD_DEFAULT));
+
+    auto slot = face_->glyph;
+    Bitmap bitmap;
+    bitmap.codepoint_ = codepoint;
+    bitmap.advance_ = static_cast<int>(slot->advance.x / 64);
+    // nothing to draw: space, control characters
+    if (slot->format == FT_GLYPH_FORMAT_OUTLINE && slot->outline.n_points == 0) {
+        return bitmap;
+    }
+
+    check(FT_Render_Glyph(slot, FT_RENDER_MODE_SDF));
+    bitmap.offsetX_ = slot->bitmap_left;
+    bitmap.offsetY_ = slot->bitmap_top;
+    bitmap.width_ = slot->bitmap.width;
+    bitmap.height_ = slot->bitmap.rows;
+    bitmap.pixels_.resize(static_cast<size_t>(bitmap.width_) * bitmap.height_);
+    auto pitch = std::abs(slot->bitmap.pitch);
+    for (uint32_t row = 0; row < bitmap.height_; row++) {
+        memcpy(&bitmap.pixels_[static_cast<size_t>(row) * bitmap.width_], slot->bitmap.buffer + static_cast<size_t>(row) * pitch, bitmap.width_);
+    }
+    return bitmap;
+}
+
+std::vector<Font::Bitmap> Font::renderSdf(const std::string& path, uint32_t size, const std::vector<uint32_t>& codepoints, uint32_t spread, uint32_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min<uint32_t>(threads, static_cast<uint32_t>(codepoints.size()));
+
+    std::vector<Bitmap> bitmaps(codepoints.size());
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    for (uint32_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            try {
+                Font font(path, size);
+                // interleaved, so the expensive glyphs don't all land on one worker
+                for (size_t i = t; i < codepoints.size(); i += threads) {
+                    bitmaps[i] = font.renderSdf(codepoints[i], spread);
+                }
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return bitmaps;
+}
 
 void Font::renderMode(FT_Render_Mode mode) {
     check(FT_Render_Glyph(face_->glyph, mode));
@@ -0,0 +1,54 @@
+#include "FontManager.h"
+#include <stdexcept>
+
+FontManager::FontManager() {
+    if (FT_Init_FreeType(&library_)) {
+        throw std::runtime_error("failed to init FreeType!");
+    }
+}
+
+FontManager::~FontManager() {
+    glyphSets_.clear();
+    for (auto& [path, face] : faces_) {
+        FT_Done_Face(face);
+    }
+    FT_Done_FreeType(library_);
+}
+
+FT_Face FontManager::face(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return openFace(path);
+}
+
+FT_Face FontManager::openFace(const std::string& path) {
+    auto it = faces_.find(path);
+    if (it != faces_.end()) {
+        return it->second;
+    }
+
+    FT_Face face;
+    if (FT_New_Face(library_, path.c_str(), 0, &face)) {
+        throw std::runtime_error("failed to open font " + path);
+    }
+    faces_.emplace(path, face);
+    return face;
+}
+
+GlyphCache& FontManager::glyphs(const std::string& path, uint32_t size, uint32_t spread, uint32_t atlasSize) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& glyphs = glyphSets_[{path, size, spread, atlasSize}];
+    if (!glyphs) {
+        glyphs = std::make_unique<GlyphCache>(library_, openFace(path), path, size, spread, atlasSize);
+    }
+    return *glyphs;
+}
+
+size_t FontManager::faceCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return faces_.size();
+}
+
+size_t FontManager::glyphSetCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return glyphSets_.size();
+}
@@ -1,13 +1,14 @@
 #include "FrameBuffer.h"
 #include "vulkan/vulkan_core.h"
 #include "Tools.h"
+#include "HostAllocator.h"
 
 FrameBuffer::FrameBuffer(VkDevice device) : device_(device) {
 
 }
 
 FrameBuffer::~FrameBuffer() {
-    vkDestroyFramebuffer(device_, frameBuffer_, nullptr);
+    vkDestroyFramebuffer(device_, frameBuffer_, HostAllocator::callbacks(HostAllocator::ObjectType::FrameBuffer));
 }
 
 void FrameBuffer::init() {
@@ -21,5 +22,5 @@ void FrameBuffer::init() {
     frameBufferInfo.layers = layers_;
     frameBufferInfo.attachmentCount = attachmentCount_;
     frameBufferInfo.pAttachments = pAttachments_;
-    VK_CHECK(vkCreateFramebuffer(device_, &frameBufferInfo, nullptr, &frameBuffer_));
+    VK_CHECK(vkCreateFramebuffer(device_, &frameBufferInfo, HostAllocator::callbacks(HostAllocator::ObjectType::FrameBuffer), &frameBuffer_));
 }
\ No newline at end of file
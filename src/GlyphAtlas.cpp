@@ -0,0 +1,81 @@
+#include "GlyphAtlas.h"
+#include <algorithm>
+#include <cstring>
+
+GlyphAtlas::GlyphAtlas(uint32_t width, uint32_t height, uint32_t padding) : width_(width), height_(height), padding_(padding), pixels_(static_cast<size_t>(width) * height, 0) {
+
+}
+
+std::optional<GlyphAtlas::Rect> GlyphAtlas::insert(uint32_t width, uint32_t height, const uint8_t* pixels, uint32_t pitch) {
+    auto paddedWidth = width + padding_, paddedHeight = height + padding_;
+
+    // the shortest shelf that is tall enough and has room wastes the least
+    Shelf* best = nullptr;
+    for (auto& shelf : shelves_) {
+        if (shelf.height_ >= paddedHeight && shelf.x_ + paddedWidth <= width_ && (!best || shelf.height_ < best->height_)) {
+            best = &shelf;
+        }
+    }
+    if (!best) {
+        auto y = shelves_.empty() ? padding_ : shelves_.back().y_ + shelves_.back().height_;
+        auto shelfHeight = std::min((paddedHeight + shelfGranularity_ - 1) / shelfGranularity_ * shelfGranularity_, height_ - std::min(y, height_));
+        if (shelfHeight < paddedHeight || padding_ + paddedWidth > width_) {
+            return std::nullopt;
+        }
+        shelves_.push_back({y, shelfHeight, padding_});
+        best = &shelves_.back();
+    }
+
+    Rect rect{best->x_, best->y_, width, height, static_cast<uint32_t>(best - shelves_.data())};
+    best->x_ += paddedWidth;
+
+    for (uint32_t row = 0; row < height; row++) {
+        std::memcpy(&pixels_[static_cast<size_t>(rect.y_ + row) * width_ + rect.x_], pixels + static_cast<size_t>(row) * pitch, width);
+    }
+    markDirty(rect);
+    return rect;
+}
+
+void GlyphAtlas::evictShelf(uint32_t shelf) {
+    auto& current = shelves_[shelf];
+    // the trailing padding row belongs to the shelf, the one above it to the previous shelf
+    Rect rect{0, current.y_, width_, current.height_, shelf};
+    for (uint32_t row = 0; row < rect.height_; row++) {
+        std::fill_n(&pixels_[static_cast<size_t>(rect.y_ + row) * width_], width_, 0);
+    }
+    current.x_ = padding_;
+    markDirty(rect);
+}
+
+void GlyphAtlas::clear() {
+    shelves_.clear();
+    std::fill(pixels_.begin(), pixels_.end(), 0);
+    dirty_.clear();
+    markDirty({0, 0, width_, height_, 0});
+}
+
+void GlyphAtlas::restore(const std::vector<Shelf>& shelves, const uint8_t* pixels) {
+    shelves_ = shelves;
+    std::memcpy(pixels_.data(), pixels, pixels_.size());
+    dirty_.clear();
+}
+
+void GlyphAtlas::markDirty(const Rect& rect) {
+    auto contains = [](const Rect& outer, const Rect& inner) {
+        return inner.x_ >= outer.x_ && inner.y_ >= outer.y_ && inner.x_ + inner.width_ <= outer.x_ + outer.width_ && inner.y_ + inner.height_ <= outer.y_ + outer.height_;
+    };
+    for (const auto& dirty : dirty_) {
+        if (contains(dirty, rect)) {
+            return ;
+        }
+    }
+    // glyphs never overlap each other, only whole shelves overlap glyphs
+    dirty_.erase(std::remove_if(dirty_.begin(), dirty_.end(), [&](const Rect& dirty) { return contains(rect, dirty); }), dirty_.end());
+    dirty_.push_back(rect);
+}
+
+std::vector<GlyphAtlas::Rect> GlyphAtlas::takeDirty() {
+    std::vector<Rect> dirty;
+    dirty.swap(dirty_);
+    return dirty;
+}
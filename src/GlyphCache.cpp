@@ -0,0 +1,188 @@
+#include "GlyphCache.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+GlyphCache::GlyphCache(const std::string& path, uint32_t size, uint32_t spread, uint32_t atlasSize) :
+    font_(path, size), path_(path), size_(size), spread_(spread), atlas_(atlasSize, atlasSize) {
+    // the atlas keeps its first texel blank, sample only its center
+    blankUv_ = glm::vec2(0.5f) / glm::vec2(atlas_.width(), atlas_.height());
+}
+
+GlyphCache::GlyphCache(FT_Library library, FT_Face face, const std::string& path, uint32_t size, uint32_t spread, uint32_t atlasSize) :
+    font_(library, face, size), path_(path), size_(size), spread_(spread), atlas_(atlasSize, atlasSize) {
+    blankUv_ = glm::vec2(0.5f) / glm::vec2(atlas_.width(), atlas_.height());
+}
+
+void GlyphCache::preload(const std::vector<uint32_t>& codepoints) {
+    std::vector<uint32_t> missing;
+    for (auto codepoint : codepoints) {
+        if (!glyphs_.count(codepoint)) {
+            missing.push_back(codepoint);
+        }
+    }
+    for (const auto& bitmap : Font::renderSdf(path_, size_, missing, spread_)) {
+        add(bitmap);
+    }
+}
+
+void GlyphCache::beginFrame(uint64_t frame, uint64_t completedFrame) {
+    frame_ = frame;
+    completedFrame_ = completedFrame;
+}
+
+Font::Character GlyphCache::glyph(char32_t codepoint) {
+    auto it = glyphs_.find(codepoint);
+    if (it == glyphs_.end()) {
+        return add(font_.renderSdf(codepoint, spread_));
+    }
+    if (it->second.packed_) {
+        shelfLastUse_[it->second.shelf_] = frame_;
+    }
+    return it->second.character_;
+}
+
+Font::Character GlyphCache::add(const Font::Bitmap& bitmap) {
+    Entry entry;
+    auto& character = entry.character_;
+    character.char_ = static_cast<char>(bitmap.codepoint_);
+    character.offsetX_ = bitmap.offsetX_;
+    character.offsetY_ = bitmap.offsetY_;
+    character.width_ = bitmap.width_;
+    character.height_ = bitmap.height_;
+    character.advance_ = bitmap.advance_;
+    character.uvMin_ = character.uvMax_ = blankUv_;
+
+    if (!bitmap.pixels_.empty()) {
+        auto rect = atlas_.insert(bitmap.width_, bitmap.height_, bitmap.pixels_.data(), bitmap.width_);
+        if (!rect && evict(bitmap.height_)) {
+            rect = atlas_.insert(bitmap.width_, bitmap.height_, bitmap.pixels_.data(), bitmap.width_);
+        }
+        if (!rect) {
+            // every shelf is in use: draw a gap for now, and don't cache it so it is tried again
+            character.uvMax_ = character.uvMin_;
+            return character;
+        }
+
+        auto atlasSize = glm::vec2(atlas_.width(), atlas_.height());
+        character.uvMin_ = glm::vec2(rect->x_, rect->y_) / atlasSize;
+        character.uvMax_ = glm::vec2(rect->x_ + rect->width_, rect->y_ + rect->height_) / atlasSize;
+        entry.shelf_ = rect->shelf_;
+        entry.packed_ = true;
+
+        shelfGlyphs_.resize(atlas_.shelfCount());
+        shelfLastUse_.resize(atlas_.shelfCount(), 0);
+        shelfGlyphs_[rect->shelf_].push_back(bitmap.codepoint_);
+        shelfLastUse_[rect->shelf_] = frame_;
+    }
+
+    glyphs_[bitmap.codepoint_] = entry;
+    return character;
+}
+
+bool GlyphCache::evict(uint32_t height) {
+    auto victim = std::numeric_limits<uint32_t>::max();
+    for (uint32_t shelf = 0; shelf < shelfLastUse_.size(); shelf++) {
+        if (shelfLastUse_[shelf] >= completedFrame_ || !atlas_.fits(shelf, height)) {
+            continue;
+        }
+        if (victim == std::numeric_limits<uint32_t>::max() || shelfLastUse_[shelf] < shelfLastUse_[victim]) {
+            victim = shelf;
+        }
+    }
+    if (victim == std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+
+    for (auto codepoint : shelfGlyphs_[victim]) {
+        glyphs_.erase(codepoint);
+    }
+    shelfGlyphs_[victim].clear();
+    atlas_.evictShelf(victim);
+    evictions_++;
+    return true;
+}
+
+GlyphCache::BakedInfo GlyphCache::info() const {
+    BakedInfo info;
+    info.size_ = size_;
+    info.spread_ = spread_;
+    info.atlasSize_ = atlas_.width();
+    // cheap check that the pack was baked from this font
+    std::error_code error;
+    info.fontBytes_ = static_cast<uint32_t>(std::filesystem::file_size(path_, error));
+    return info;
+}
+
+void GlyphCache::bake(AssetPack::Writer& writer) const {
+    std::vector<BakedGlyph> glyphs;
+    for (const auto& [codepoint, entry] : glyphs_) {
+        const auto& character = entry.character_;
+        BakedGlyph glyph;
+        glyph.codepoint_ = codepoint;
+        glyph.offsetX_ = character.offsetX_;
+        glyph.offsetY_ = character.offsetY_;
+        glyph.width_ = character.width_;
+        glyph.height_ = character.height_;
+        glyph.advance_ = character.advance_;
+        glyph.x_ = static_cast<uint32_t>(character.uvMin_.x * atlas_.width() + 0.5f);
+        glyph.y_ = static_cast<uint32_t>(character.uvMin_.y * atlas_.height() + 0.5f);
+        glyph.shelf_ = entry.shelf_;
+        glyph.packed_ = entry.packed_;
+        glyphs.push_back(glyph);
+    }
+
+    auto baked = info();
+    writer.add("glyphs/info", &baked, sizeof(baked), 0, 0, path_);
+    writer.add("glyphs/metrics", glyphs.data(), sizeof(BakedGlyph) * glyphs.size());
+    writer.add("glyphs/shelves", atlas_.shelves().data(), sizeof(GlyphAtlas::Shelf) * atlas_.shelves().size());
+    writer.add("glyphs/atlas", atlas_.pixels().data(), atlas_.pixels().size(), atlas_.width(), atlas_.height());
+}
+
+bool GlyphCache::restore(const AssetPack& pack) {
+    auto baked = pack.find("glyphs/info", path_);
+    auto metrics = pack.find("glyphs/metrics");
+    auto shelves = pack.find("glyphs/shelves");
+    auto pixels = pack.find("glyphs/atlas");
+    if (!baked || !metrics || !shelves || !pixels || baked->size_ != sizeof(BakedInfo)) {
+        return false;
+    }
+    BakedInfo expected = info(), actual;
+    std::memcpy(&actual, baked->data_, sizeof(actual));
+    if (std::memcmp(&expected, &actual, sizeof(actual)) != 0 || pixels->size_ != atlas_.pixels().size()) {
+        return false;
+    }
+
+    std::vector<GlyphAtlas::Shelf> packing(shelves->size_ / sizeof(GlyphAtlas::Shelf));
+    std::memcpy(packing.data(), shelves->data_, sizeof(GlyphAtlas::Shelf) * packing.size());
+    atlas_.restore(packing, pixels->data_);
+
+    glyphs_.clear();
+    shelfGlyphs_.assign(packing.size(), {});
+    shelfLastUse_.assign(packing.size(), 0);
+    auto atlasSize = glm::vec2(atlas_.width(), atlas_.height());
+    for (size_t i = 0; i < metrics->size_ / sizeof(BakedGlyph); i++) {
+        BakedGlyph glyph;
+        std::memcpy(&glyph, metrics->data_ + i * sizeof(BakedGlyph), sizeof(glyph));
+
+        Entry entry;
+        auto& character = entry.character_;
+        character.char_ = static_cast<char>(glyph.codepoint_);
+        character.offsetX_ = glyph.offsetX_;
+        character.offsetY_ = glyph.offsetY_;
+        character.width_ = glyph.width_;
+        character.height_ = glyph.height_;
+        character.advance_ = glyph.advance_;
+        character.uvMin_ = character.uvMax_ = blankUv_;
+        if (glyph.packed_ && glyph.shelf_ < packing.size()) {
+            character.uvMin_ = glm::vec2(glyph.x_, glyph.y_) / atlasSize;
+            character.uvMax_ = glm::vec2(glyph.x_ + glyph.width_, glyph.y_ + glyph.height_) / atlasSize;
+            entry.shelf_ = glyph.shelf_;
+            entry.packed_ = true;
+            shelfGlyphs_[glyph.shelf_].push_back(glyph.codepoint_);
+        }
+        glyphs_[glyph.codepoint_] = entry;
+    }
+    return true;
+}
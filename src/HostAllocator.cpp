@@ -0,0 +1,274 @@
+#include "HostAllocator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <memory>
+
+namespace {
+
+// Command-scope allocations are freed before the call that made them returns, so a bump pointer
+// that rewinds whenever nothing is live covers them without touching malloc.
+struct Arena {
+    static constexpr size_t capacity_ = 256 << 10;
+
+    char* allocate(size_t size) {
+        if (!buffer_) {
+            buffer_ = std::make_unique<char[]>(capacity_);
+        }
+        if (offset_ + size > capacity_) {
+            return nullptr;
+        }
+        auto memory = buffer_.get() + offset_;
+        offset_ += size;
+        live_++;
+        return memory;
+    }
+
+    void release() {
+        if (--live_ == 0) {
+            offset_ = 0;
+        }
+    }
+
+    std::unique_ptr<char[]> buffer_;
+    size_t offset_ = 0;
+    size_t live_ = 0;
+};
+
+thread_local Arena threadArena;
+
+// sits right in front of every block we hand out
+struct Header {
+    void* base_;
+    size_t size_;
+    void* counters_;
+    Arena* arena_;
+};
+
+Header header(void* memory) {
+    Header header;
+    std::memcpy(&header, static_cast<char*>(memory) - sizeof(Header), sizeof(Header));
+    return header;
+}
+
+void add(HostAllocator::Counters& total, const HostAllocator::Counters& counters) {
+    total.allocations_ += counters.allocations_;
+    total.reallocations_ += counters.reallocations_;
+    total.frees_ += counters.frees_;
+    total.arenaAllocations_ += counters.arenaAllocations_;
+    total.bytes_ += counters.bytes_;
+    // peaks of different types need not coincide, so this is an upper bound
+    total.peakBytes_ += counters.peakBytes_;
+}
+
+}
+
+HostAllocator::HostAllocator() {
+    for (size_t i = 0; i < trackers_.size(); i++) {
+        trackers_[i].allocator_ = this;
+        trackers_[i].type_ = static_cast<ObjectType>(i);
+
+        callbacks_[i].pUserData = &trackers_[i];
+        callbacks_[i].pfnAllocation = allocation;
+        callbacks_[i].pfnReallocation = reallocation;
+        callbacks_[i].pfnFree = free;
+        callbacks_[i].pfnInternalAllocation = internalAllocation;
+        callbacks_[i].pfnInternalFree = internalFree;
+    }
+}
+
+HostAllocator& HostAllocator::instance() {
+    static HostAllocator allocator;
+    return allocator;
+}
+
+const char* HostAllocator::name(ObjectType type) {
+    switch (type) {
+    case ObjectType::Instance:      return "instance";
+    case ObjectType::Device:        return "device";
+    case ObjectType::Memory:        return "memory";
+    case ObjectType::Buffer:        return "buffer";
+    case ObjectType::Image:         return "image";
+    case ObjectType::Sampler:       return "sampler";
+    case ObjectType::Pipeline:      return "pipeline";
+    case ObjectType::Shader:        return "shader";
+    case ObjectType::RenderPass:    return "render pass";
+    case ObjectType::FrameBuffer:   return "framebuffer";
+    case ObjectType::Descriptor:    return "descriptor";
+    case ObjectType::Command:       return "command";
+    case ObjectType::Sync:          return "sync";
+    case ObjectType::Query:         return "query";
+    case ObjectType::SwapChain:     return "swapchain";
+    default:                        return "other";
+    }
+}
+
+void HostAllocator::enable(bool arena) {
+    enabled_ = true;
+    arena_ = arena;
+}
+
+const VkAllocationCallbacks* HostAllocator::callbacks(ObjectType type) {
+    auto& allocator = instance();
+    return allocator.enabled_ ? &allocator.callbacks_[static_cast<size_t>(type)] : nullptr;
+}
+
+void* VKAPI_PTR HostAllocator::allocation(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    auto& tracker = *static_cast<Tracker*>(userData);
+    auto memory = tracker.allocator_->allocate(tracker, size, alignment, scope);
+    if (memory) {
+        tracker.counters_[scope].allocations_++;
+    }
+    return memory;
+}
+
+void* VKAPI_PTR HostAllocator::reallocation(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    if (!original) {
+        return allocation(userData, size, alignment, scope);
+    }
+    if (size == 0) {
+        free(userData, original);
+        return nullptr;
+    }
+
+    auto& tracker = *static_cast<Tracker*>(userData);
+    auto memory = tracker.allocator_->allocate(tracker, size, alignment, scope);
+    // on failure the original has to stay valid
+    if (!memory) {
+        return nullptr;
+    }
+    std::memcpy(memory, original, std::min(size, header(original).size_));
+    release(original);
+    tracker.counters_[scope].reallocations_++;
+    return memory;
+}
+
+void VKAPI_PTR HostAllocator::free(void* userData, void* memory) {
+    if (!memory) {
+        return ;
+    }
+    static_cast<AtomicCounters*>(header(memory).counters_)->frees_++;
+    release(memory);
+}
+
+void VKAPI_PTR HostAllocator::internalAllocation(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope) {
+    static_cast<Tracker*>(userData)->allocator_->internalBytes_ += size;
+}
+
+void VKAPI_PTR HostAllocator::internalFree(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope) {
+    static_cast<Tracker*>(userData)->allocator_->internalBytes_ -= size;
+}
+
+void* HostAllocator::allocate(Tracker& tracker, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    alignment = std::max(alignment, alignof(std::max_align_t));
+    auto total = size + alignment + sizeof(Header);
+
+    Arena* arena = nullptr;
+    char* base = nullptr;
+    if (arena_ && scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) {
+        base = threadArena.allocate(total);
+        arena = base ? &threadArena : nullptr;
+    }
+    if (!base) {
+        base = static_cast<char*>(std::malloc(total));
+    }
+    if (!base) {
+        return nullptr;
+    }
+
+    auto address = reinterpret_cast<uintptr_t>(base + sizeof(Header));
+    address = (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    auto memory = reinterpret_cast<char*>(address);
+
+    auto& counters = tracker.counters_[scope];
+    Header header{base, size, &counters, arena};
+    std::memcpy(memory - sizeof(Header), &header, sizeof(Header));
+
+    if (arena) {
+        counters.arenaAllocations_++;
+    }
+    auto bytes = counters.bytes_ += size;
+    auto peak = counters.peakBytes_.load();
+    while (bytes > peak && !counters.peakBytes_.compare_exchange_weak(peak, bytes)) {
+    }
+    return memory;
+}
+
+void HostAllocator::release(void* memory) {
+    auto block = header(memory);
+    static_cast<AtomicCounters*>(block.counters_)->bytes_ -= block.size_;
+    if (block.arena_) {
+        block.arena_->release();
+    } else {
+        std::free(block.base_);
+    }
+}
+
+HostAllocator::Counters HostAllocator::Stats::total(ObjectType type) const {
+    Counters total;
+    for (const auto& counters : counters_[static_cast<size_t>(type)]) {
+        add(total, counters);
+    }
+    return total;
+}
+
+HostAllocator::Counters HostAllocator::Stats::total() const {
+    Counters total;
+    for (size_t i = 0; i < counters_.size(); i++) {
+        add(total, this->total(static_cast<ObjectType>(i)));
+    }
+    return total;
+}
+
+HostAllocator::Stats HostAllocator::stats() const {
+    Stats stats;
+    for (size_t i = 0; i < trackers_.size(); i++) {
+        for (size_t scope = 0; scope < scopeCount_; scope++) {
+            const auto& from = trackers_[i].counters_[scope];
+            auto& to = stats.counters_[i][scope];
+            to.allocations_ = from.allocations_;
+            to.reallocations_ = from.reallocations_;
+            to.frees_ = from.frees_;
+            to.arenaAllocations_ = from.arenaAllocations_;
+            to.bytes_ = from.bytes_;
+            to.peakBytes_ = from.peakBytes_;
+        }
+    }
+    stats.internalBytes_ = internalBytes_;
+    return stats;
+}
+
+uint64_t HostAllocator::allocations() const {
+    uint64_t count = 0;
+    for (const auto& tracker : trackers_) {
+        for (const auto& counters : tracker.counters_) {
+            count += counters.allocations_ + counters.reallocations_;
+        }
+    }
+    return count;
+}
+
+std::string HostAllocator::summary() const {
+    static const char* scopes[scopeCount_] = {"command", "object", "cache", "device", "instance"};
+
+    auto stats = this->stats();
+    auto total = stats.total();
+    std::string result = std::format("host allocations: {} allocs, {} reallocs, {} frees, {} from the arena, {} bytes live, {} internal",
+        total.allocations_, total.reallocations_, total.frees_, total.arenaAllocations_, total.bytes_, stats.internalBytes_);
+    for (size_t i = 0; i < stats.counters_.size(); i++) {
+        auto type = stats.total(static_cast<ObjectType>(i));
+        if (type.allocations_ == 0) {
+            continue;
+        }
+        std::string perScope;
+        for (size_t scope = 0; scope < scopeCount_; scope++) {
+            auto count = stats.counters_[i][scope].allocations_;
+            if (count != 0) {
+                perScope += std::format("{}{} {}", perScope.empty() ? "" : ", ", scopes[scope], count);
+            }
+        }
+        result += std::format("\n  {:<12} {:>8} allocs ({}), {} bytes live, peak {}", name(static_cast<ObjectType>(i)), type.allocations_, perScope, type.bytes_, type.peakBytes_);
+    }
+    return result;
+}
@@ -1,15 +1,20 @@
 #include "Image.h"
 #include "vulkan/vulkan_core.h"
 #include "Tools.h"
+#include "HostAllocator.h"
 
-Image::Image(VkPhysicalDevice physicalDevice, VkDevice device) : physicalDevice_(physicalDevice), device_(device) {
+Image::Image(VkPhysicalDevice physicalDevice, VkDevice device, MemoryAllocator* allocator) : physicalDevice_(physicalDevice), device_(device), allocator_(allocator) {
     
 }
 
 Image::~Image() {
-    vkDestroyImageView(device_, view(), nullptr);
-    vkFreeMemory(device_, memory_, nullptr);
-    vkDestroyImage(device_, image_, nullptr);
+    vkDestroyImageView(device_, view(), HostAllocator::callbacks(HostAllocator::ObjectType::Image));
+    vkDestroyImage(device_, image_, HostAllocator::callbacks(HostAllocator::ObjectType::Image));
+    if (allocator_) {
+        allocator_->free(allocation_);
+    } else {
+        vkFreeMemory(device_, memory_, HostAllocator::callbacks(HostAllocator::ObjectType::Memory));
+    }
 }
 
 void Image::init() {
@@ -32,17 +37,38 @@ void Image::init() {
     imageInfo.queueFamilyIndexCount = queueFamilyIndexCount_;
     imageInfo.pQueueFamilyIndices = pQueueFamilyIndices_;
     
-    VK_CHECK(vkCreateImage(device_, &imageInfo, nullptr, &image_));
+    VK_CHECK(vkCreateImage(device_, &imageInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Image), &image_));
 
-    vkGetImageMemoryRequirements(device_, image_, &memRequirement);
+    if (allocator_) {
+        VkMemoryDedicatedRequirements dedicatedRequirements{};
+        dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+        VkMemoryRequirements2 requirements2{};
+        requirements2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+        requirements2.pNext = &dedicatedRequirements;
+        VkImageMemoryRequirementsInfo2 requirementsInfo{};
+        requirementsInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+        requirementsInfo.image = image_;
+        vkGetImageMemoryRequirements2(device_, &requirementsInfo, &requirements2);
 
-    memoryInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    memoryInfo.allocationSize = memRequirement.size;
-    memoryInfo.memoryTypeIndex = Tools::findMemoryType(physicalDevice_, memRequirement.memoryTypeBits, memoryProperties_);
+        // transient attachments may land in lazily allocated memory, which is only committed per allocation
+        auto dedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation || (usage_ & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT);
+        auto kind = tiling_ == VK_IMAGE_TILING_LINEAR ? MemoryAllocator::Kind::Linear : MemoryAllocator::Kind::Optimal;
+        allocation_ = allocator_->allocate(requirements2.memoryRequirements, memoryProperties_, preferredMemoryProperties_, memoryUsage_, memoryTag_, kind, dedicated, image_);
+        memory_ = allocation_.memory_;
+        VK_CHECK(vkBindImageMemory(device_, image_, memory_, allocation_.offset_));
+    } else {
+        vkGetImageMemoryRequirements(device_, image_, &memRequirement);
 
-    VK_CHECK(vkAllocateMemory(device_, &memoryInfo, nullptr, &memory_));
+        memoryInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        memoryInfo.allocationSize = memRequirement.size;
+        memoryInfo.memoryTypeIndex = memoryUsage_ == Tools::MemoryUsage::Unknown ?
+            Tools::findMemoryType(physicalDevice_, memRequirement.memoryTypeBits, memoryProperties_, preferredMemoryProperties_) :
+            Tools::findMemoryType(physicalDevice_, memRequirement.memoryTypeBits, memoryProperties_, memoryUsage_);
 
-    vkBindImageMemory(device_, image_, memory_, 0);
+        VK_CHECK(vkAllocateMemory(device_, &memoryInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Memory), &memory_));
+
+        vkBindImageMemory(device_, image_, memory_, 0);
+    }
 
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image = image_;
@@ -50,5 +76,5 @@ void Image::init() {
     viewInfo.format = format_;
     viewInfo.subresourceRange = subresourcesRange_;
 
-    VK_CHECK(vkCreateImageView(device_, &viewInfo, nullptr, &view_));
+    VK_CHECK(vkCreateImageView(device_, &viewInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Image), &view_));
 }
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include "MemoryAllocator.h"
+#include "vulkan/vulkan_core.h"
+#include "Tools.h"
+#include <algorithm>
+#include "HostAllocator.h"
+
+MemoryAllocator::MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device) : physicalDevice_(physicalDevice), device_(device) {
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &memoryProperties_);
+    pools_.resize(memoryProperties_.memoryTypeCount * 2);
+    heapReserved_.resize(memoryProperties_.memoryHeapCount);
+}
+
+MemoryAllocator::~MemoryAllocator() {
+    for (auto& pool : pools_) {
+        for (auto& block : pool.blocks_) {
+            vkFreeMemory(device_, block->memory_, HostAllocator::callbacks(HostAllocator::ObjectType::Memory));
+        }
+    }
+}
+
+VkDeviceMemory MemoryAllocator::allocateMemory(VkDeviceSize size, uint32_t memoryType, void** mapped, const void* next) {
+    VkMemoryAllocateInfo memoryInfo{};
+    memoryInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memoryInfo.pNext = next;
+    memoryInfo.allocationSize = size;
+    memoryInfo.memoryTypeIndex = memoryType;
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    if (vkAllocateMemory(device_, &memoryInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Memory), &memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate device memory!");
+    }
+
+    *mapped = nullptr;
+    if (memoryProperties_.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        VK_CHECK(vkMapMemory(device_, memory, 0, VK_WHOLE_SIZE, 0, mapped));
+    }
+    heapReserved_[memoryProperties_.memoryTypes[memoryType].heapIndex] += size;
+    return memory;
+}
+
+void MemoryAllocator::freeMemory(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryType) {
+    vkFreeMemory(device_, memory, HostAllocator::callbacks(HostAllocator::ObjectType::Memory));
+    heapReserved_[memoryProperties_.memoryTypes[memoryType].heapIndex] -= size;
+}
+
+MemoryAllocator::Allocation MemoryAllocator::allocateDedicated(VkDeviceSize size, uint32_t memoryType, Kind kind, VkImage image, VkBuffer buffer) {
+    // tells the driver which resource owns the memory, so it can place and compress it for that one
+    VkMemoryDedicatedAllocateInfo dedicatedInfo{};
+    dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicatedInfo.image = image;
+    dedicatedInfo.buffer = buffer;
+    auto owned = image != VK_NULL_HANDLE || buffer != VK_NULL_HANDLE;
+
+    Allocation allocation{};
+    allocation.memory_ = allocateMemory(size, memoryType, &allocation.mapped_, owned ? &dedicatedInfo : nullptr);
+    allocation.size_ = size;
+    allocation.memoryType_ = memoryType;
+    allocation.flags_ = memoryProperties_.memoryTypes[memoryType].propertyFlags;
+    allocation.kind_ = kind;
+    allocation.dedicated_ = true;
+
+    dedicatedCount_++;
+    dedicatedBytes_ += size;
+    allocationCount_++;
+    return allocation;
+}
+
+MemoryAllocator::Allocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferred, Tools::MemoryUsage usage, Tools::MemoryTag tag, Kind kind, bool dedicated, VkImage image, VkBuffer buffer) {
+    auto memoryType = usage == Tools::MemoryUsage::Unknown ?
+        Tools::findMemoryType(physicalDevice_, requirements.memoryTypeBits, properties, preferred) :
+        Tools::findMemoryType(physicalDevice_, requirements.memoryTypeBits, properties, usage);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dedicated || requirements.size > blockSize_ / 2) {
+        auto allocation = allocateDedicated(requirements.size, memoryType, kind, image, buffer);
+        allocation.tag_ = tag;
+        tags_[static_cast<size_t>(tag)].bytes_ += allocation.size_;
+        tags_[static_cast<size_t>(tag)].count_++;
+        return allocation;
+    }
+
+    Allocation allocation{};
+    allocation.memoryType_ = memoryType;
+    allocation.flags_ = memoryProperties_.memoryTypes[memoryType].propertyFlags;
+    allocation.kind_ = kind;
+
+    auto& blocks = pool(memoryType, kind).blocks_;
+    for (auto& block : blocks) {
+        if (block.get() != evacuating_ && block->buddy_->allocate(requirements.size, requirements.alignment, allocation.offset_, allocation.order_)) {
+            allocation.block_ = block.get();
+            break;
+        }
+    }
+
+    // rather than growing the pool during a defragmentation pass, stay in the block being evacuated
+    auto inPool = evacuating_ && std::any_of(blocks.begin(), blocks.end(), [this](const std::unique_ptr<Block>& b) { return b.get() == evacuating_; });
+    if (!allocation.block_ && inPool && evacuating_->buddy_->allocate(requirements.size, requirements.alignment, allocation.offset_, allocation.order_)) {
+        allocation.block_ = evacuating_;
+    }
+
+    if (!allocation.block_) {
+        auto block = std::make_unique<Block>();
+        block->memory_ = allocateMemory(blockSize_, memoryType, &block->mapped_);
+        block->buddy_ = std::make_unique<BuddyAllocator>(blockSize_, minAllocation_);
+        block->buddy_->allocate(requirements.size, requirements.alignment, allocation.offset_, allocation.order_);
+        allocation.block_ = block.get();
+        blocks.push_back(std::move(block));
+    }
+
+    auto block = static_cast<Block*>(allocation.block_);
+    block->stuck_ = false;
+    allocation.memory_ = block->memory_;
+    allocation.size_ = block->buddy_->blockSize(allocation.order_);
+    allocation.mapped_ = block->mapped_ ? static_cast<char*>(block->mapped_) + allocation.offset_ : nullptr;
+    allocation.tag_ = tag;
+    allocationCount_++;
+    tags_[static_cast<size_t>(tag)].bytes_ += allocation.size_;
+    tags_[static_cast<size_t>(tag)].count_++;
+    return allocation;
+}
+
+void MemoryAllocator::free(Allocation& allocation) {
+    if (allocation.memory_ == VK_NULL_HANDLE) {
+        return ;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    allocationCount_--;
+    tags_[static_cast<size_t>(allocation.tag_)].bytes_ -= allocation.size_;
+    tags_[static_cast<size_t>(allocation.tag_)].count_--;
+    if (allocation.dedicated_) {
+        freeMemory(allocation.memory_, allocation.size_, allocation.memoryType_);
+        dedicatedCount_--;
+        dedicatedBytes_ -= allocation.size_;
+        allocation = {};
+        return ;
+    }
+
+    auto block = static_cast<Block*>(allocation.block_);
+    auto memoryType = allocation.memoryType_;
+    auto& blocks = pool(allocation.memoryType_, allocation.kind_).blocks_;
+    block->buddy_->free(allocation.offset_, allocation.order_);
+    block->stuck_ = false;
+    allocation = {};
+
+    // one empty block per pool stays around, so a resource recreated every frame doesn't hit vkAllocateMemory each time
+    if (!block->buddy_->empty() || block == evacuating_) {
+        return ;
+    }
+    auto empties = std::count_if(blocks.begin(), blocks.end(), [](const std::unique_ptr<Block>& b) { return b->buddy_->empty(); });
+    if (empties > 1) {
+        freeMemory(block->memory_, block->buddy_->size(), memoryType);
+        blocks.erase(std::find_if(blocks.begin(), blocks.end(), [block](const std::unique_ptr<Block>& b) { return b.get() == block; }));
+    }
+}
+
+MemoryAllocator::Stats MemoryAllocator::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats{};
+    for (auto& pool : pools_) {
+        for (auto& block : pool.blocks_) {
+            stats.blocks_++;
+            stats.reserved_ += block->buddy_->size();
+            stats.used_ += block->buddy_->used();
+        }
+    }
+    stats.dedicated_ = dedicatedCount_;
+    stats.reserved_ += dedicatedBytes_;
+    stats.used_ += dedicatedBytes_;
+    stats.allocations_ = allocationCount_;
+    stats.tags_ = tags_;
+
+    stats.heaps_.resize(memoryProperties_.memoryHeapCount);
+    for (uint32_t i = 0; i < memoryProperties_.memoryHeapCount; i++) {
+        auto& heap = stats.heaps_[i];
+        heap.size_ = memoryProperties_.memoryHeaps[i].size;
+        heap.deviceLocal_ = memoryProperties_.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+        heap.reserved_ = heapReserved_[i];
+        heap.usage_ = heapReserved_[i];
+        heap.budget_ = heap.size_;
+    }
+
+    if (memoryBudget_) {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+        budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+        VkPhysicalDeviceMemoryProperties2 properties{};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        properties.pNext = &budget;
+        vkGetPhysicalDeviceMemoryProperties2(physicalDevice_, &properties);
+
+        for (uint32_t i = 0; i < memoryProperties_.memoryHeapCount; i++) {
+            stats.heaps_[i].usage_ = budget.heapUsage[i];
+            stats.heaps_[i].budget_ = budget.heapBudget[i];
+        }
+        stats.budgetExtension_ = true;
+    }
+    return stats;
+}
+
+bool MemoryAllocator::beginDefragmentation() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (evacuating_) {
+        return true;
+    }
+
+    Block* candidate = nullptr;
+    for (auto& pool : pools_) {
+        if (pool.blocks_.size() < 2) {
+            continue;
+        }
+
+        VkDeviceSize free = 0;
+        Block* emptiest = nullptr;
+        for (auto& block : pool.blocks_) {
+            free += block->buddy_->size() - block->buddy_->used();
+            if (!block->buddy_->empty() && !block->stuck_ && (!emptiest || block->buddy_->used() < emptiest->buddy_->used())) {
+                emptiest = block.get();
+            }
+        }
+        if (!emptiest) {
+            continue;
+        }
+
+        // only worth it when the block is mostly holes and the rest of the pool can take its contents
+        auto used = emptiest->buddy_->used();
+        auto freeElsewhere = free - (emptiest->buddy_->size() - used);
+        if (used <= emptiest->buddy_->size() / 2 && used <= freeElsewhere && (!candidate || used < candidate->buddy_->used())) {
+            candidate = emptiest;
+        }
+    }
+
+    evacuating_ = candidate;
+    return evacuating_ != nullptr;
+}
+
+VkDeviceSize MemoryAllocator::evacuatingUsed() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return evacuating_ ? evacuating_->buddy_->used() : 0;
+}
+
+VkDeviceSize MemoryAllocator::endDefragmentation() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (evacuating_ && !evacuating_->buddy_->empty()) {
+        evacuating_->stuck_ = true;
+    }
+    evacuating_ = nullptr;
+
+    VkDeviceSize reclaimed = 0;
+    for (auto& pool : pools_) {
+        auto& blocks = pool.blocks_;
+        for (auto it = blocks.begin(); it != blocks.end();) {
+            if ((*it)->buddy_->empty()) {
+                reclaimed += (*it)->buddy_->size();
+                freeMemory((*it)->memory_, (*it)->buddy_->size(), memoryTypeOf(pool));
+                it = blocks.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+    return reclaimed;
+}
@@ -2,13 +2,14 @@
 #include "vulkan/vulkan_core.h"
 #include "Tools.h"
 #include <stdexcept>
+#include "HostAllocator.h"
 
 Pipeline::Pipeline(VkDevice device) : device_(device) {
 
 }
 
 Pipeline::~Pipeline() {
-    vkDestroyPipeline(device_, pipeline_, nullptr);
+    vkDestroyPipeline(device_, pipeline_, HostAllocator::callbacks(HostAllocator::ObjectType::Pipeline));
 }
 
 void Pipeline::init() {
@@ -31,5 +32,5 @@ void Pipeline::init() {
     pipelineInfo.subpass = subpass_;
     pipelineInfo.basePipelineHandle = basePipelineHandle_;
     pipelineInfo.basePipelineIndex = basePipelineIndex_;
-    VK_CHECK(vkCreateGraphicsPipelines(device_, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline_));
+    VK_CHECK(vkCreateGraphicsPipelines(device_, VK_NULL_HANDLE, 1, &pipelineInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Pipeline), &pipeline_));
 }
\ No newline at end of file
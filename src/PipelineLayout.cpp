@@ -1,13 +1,14 @@
 #include "PipelineLayout.h"
 #include "vulkan/vulkan_core.h"
 #include "Tools.h"
+#include "HostAllocator.h"
 
 PipelineLayout::PipelineLayout(VkDevice device) : device_(device) {
 
 }
 
 PipelineLayout::~PipelineLayout() {
-    vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
+    vkDestroyPipelineLayout(device_, pipelineLayout_, HostAllocator::callbacks(HostAllocator::ObjectType::Pipeline));
 }
 
 void PipelineLayout::init() {
@@ -19,5 +20,5 @@ void PipelineLayout::init() {
     pipelineLayoutInfo.pSetLayouts = pSetLayouts_;
     pipelineLayoutInfo.pushConstantRangeCount = pushConstantRangeCount_;
     pipelineLayoutInfo.pPushConstantRanges = pPushConstantRanges_;
-    VK_CHECK(vkCreatePipelineLayout(device_, &pipelineLayoutInfo, nullptr, &pipelineLayout_));
+    VK_CHECK(vkCreatePipelineLayout(device_, &pipelineLayoutInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Pipeline), &pipelineLayout_));
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "Profiler.h"
+#include "Timer.h"
+#include <atomic>
+#include <fstream>
+#include <format>
+
+Profiler::Profiler() : origin_(Timer::nowNanoseconds()) {
+
+}
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::addCpuEvent(const char* name, uint64_t begin, uint64_t end) {
+    addEvent(name, "cpu", begin, end, currentThread());
+}
+
+void Profiler::addGpuEvent(const char* name, uint64_t begin, uint64_t end) {
+    addEvent(name, "gpu", begin, end, gpuThread_);
+}
+
+void Profiler::addEvent(const char* name, const char* category, uint64_t begin, uint64_t end, uint32_t thread) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (events_.size() >= maxEvents_) {
+        dropped_++;
+        return ;
+    }
+    events_.push_back({name, category, begin, end, thread});
+}
+
+void Profiler::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.clear();
+    dropped_ = 0;
+}
+
+bool Profiler::save(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << std::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"GPU\"}}}}", gpuThread_);
+    for (auto& event : events_) {
+        // trace timestamps are microseconds; events recorded before the profiler existed clamp to 0
+        auto begin = event.begin_ > origin_ ? event.begin_ - origin_ : 0;
+        auto duration = event.end_ > event.begin_ ? event.end_ - event.begin_ : 0;
+        file << std::format(",\n{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":1,\"tid\":{}}}",
+            event.name_, event.category_, begin / 1000.0, duration / 1000.0, event.thread_);
+    }
+    file << std::format("\n],\"otherData\":{{\"droppedEvents\":{}}}}}\n", dropped_);
+
+    return file.good();
+}
+
+uint32_t Profiler::currentThread() {
+    static std::atomic<uint32_t> next{gpuThread_ + 1};
+    thread_local uint32_t thread = next++;
+    return thread;
+}
+
+Profiler::Scope::Scope(const char* name) : name_(name), begin_(Timer::nowNanoseconds()) {
+
+}
+
+Profiler::Scope::~Scope() {
+    Profiler::instance().addCpuEvent(name_, begin_, Timer::nowNanoseconds());
+}
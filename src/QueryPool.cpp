@@ -0,0 +1,22 @@
+#include "QueryPool.h"
+#include "vulkan/vulkan_core.h"
+#include "Tools.h"
+#include "HostAllocator.h"
+
+QueryPool::QueryPool(VkDevice device) : device_(device) {
+
+}
+
+QueryPool::~QueryPool() {
+    vkDestroyQueryPool(device_, queryPool_, HostAllocator::callbacks(HostAllocator::ObjectType::Query));
+}
+
+void QueryPool::init() {
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.pNext = pNext_;
+    queryPoolInfo.queryType = queryType_;
+    queryPoolInfo.queryCount = queryCount_;
+    queryPoolInfo.pipelineStatistics = pipelineStatistics_;
+    VK_CHECK(vkCreateQueryPool(device_, &queryPoolInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Query), &queryPool_));
+}
@@ -1,13 +1,14 @@
 #include "RenderPass.h"
 #include "vulkan/vulkan_core.h"
 #include "Tools.h"
+#include "HostAllocator.h"
 
 RenderPass::RenderPass(VkDevice device) : device_(device) {
 
 }
 
 RenderPass::~RenderPass() {
-    vkDestroyRenderPass(device_, renderPass_, nullptr);
+    vkDestroyRenderPass(device_, renderPass_, HostAllocator::callbacks(HostAllocator::ObjectType::RenderPass));
 }
 
 void RenderPass::init() {
@@ -21,5 +22,5 @@ void RenderPass::init() {
     renderPassInfo.pAttachments = pAttachments_;
     renderPassInfo.dependencyCount = dependencyCount_;
     renderPassInfo.pDependencies = pDependencies_;
-    VK_CHECK(vkCreateRenderPass(device_, &renderPassInfo, nullptr, &renderPass_));
+    VK_CHECK(vkCreateRenderPass(device_, &renderPassInfo, HostAllocator::callbacks(HostAllocator::ObjectType::RenderPass), &renderPass_));
 }
\ No newline at end of file
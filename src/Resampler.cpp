@@ -0,0 +1,241 @@
+#include "Resampler.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define RESAMPLER_SSE
+#endif
+
+namespace {
+
+constexpr float pi = 3.14159265358979f;
+// output rows per band; a band also filters the few source rows its neighbours read
+constexpr uint32_t bandRows = 32;
+// output texels below which another thread costs more to start than it saves
+constexpr size_t texelsPerThread = 256 * 1024;
+constexpr uint32_t srgbSteps = 4096;
+
+struct Tables {
+    std::array<float, 256> linear{};
+    std::array<uint8_t, srgbSteps> srgb{};
+
+    Tables() {
+        for (uint32_t i = 0; i < linear.size(); i++) {
+            float c = i / 255.0f;
+            linear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        for (uint32_t i = 0; i < srgb.size(); i++) {
+            float c = i / static_cast<float>(srgbSteps - 1);
+            float s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+            srgb[i] = static_cast<uint8_t>(std::clamp(s * 255.0f + 0.5f, 0.0f, 255.0f));
+        }
+    }
+};
+
+const Tables& tables() {
+    static const Tables instance;
+    return instance;
+}
+
+float kernel(Resampler::Filter filter, float x) {
+    if (filter == Resampler::Filter::Box) {
+        return x >= -0.5f && x < 0.5f ? 1.0f : 0.0f;
+    }
+    x = std::abs(x);
+    if (x < 1e-6f) {
+        return 1.0f;
+    }
+    if (x >= 3.0f) {
+        return 0.0f;
+    }
+    return 3.0f * std::sin(pi * x) * std::sin(pi * x / 3.0f) / (pi * pi * x * x);
+}
+
+// for every output texel along one axis, the first input texel it reads and the normalized
+// weights of the ones after it, taps_ apart
+struct Weights {
+    std::vector<uint32_t> first_;
+    std::vector<uint32_t> count_;
+    std::vector<float> weights_;
+    uint32_t taps_ = 0;
+};
+
+Weights weights(uint32_t in, uint32_t out, Resampler::Filter filter) {
+    double scale = static_cast<double>(in) / out;
+    // widened when reducing, so every input texel contributes
+    double filterScale = std::max(1.0, scale);
+    double support = (filter == Resampler::Filter::Box ? 0.5 : 3.0) * filterScale;
+
+    Weights result;
+    result.taps_ = static_cast<uint32_t>(std::ceil(2.0 * support)) + 2;
+    result.first_.resize(out);
+    result.count_.resize(out);
+    result.weights_.assign(static_cast<size_t>(out) * result.taps_, 0.0f);
+    for (uint32_t o = 0; o < out; o++) {
+        double center = (o + 0.5) * scale;
+        auto left = static_cast<int64_t>(std::floor(center - support));
+        auto right = static_cast<int64_t>(std::ceil(center + support));
+        left = std::max<int64_t>(left, 0);
+        right = std::min<int64_t>(right, static_cast<int64_t>(in) - 1);
+
+        auto row = &result.weights_[static_cast<size_t>(o) * result.taps_];
+        uint32_t first = UINT32_MAX, count = 0;
+        float sum = 0.0f;
+        for (auto i = left; i <= right; i++) {
+            float w = kernel(filter, static_cast<float>((i + 0.5 - center) / filterScale));
+            if (w == 0.0f && count == 0) {
+                continue;
+            }
+            if (first == UINT32_MAX) {
+                first = static_cast<uint32_t>(i);
+            }
+            row[count++] = w;
+            sum += w;
+        }
+        while (count > 1 && row[count - 1] == 0.0f) {
+            count--;
+        }
+        if (first == UINT32_MAX || sum == 0.0f) {
+            // nothing under the kernel, take the nearest texel
+            first = static_cast<uint32_t>(std::min<double>(center, in - 1));
+            count = 1;
+            row[0] = sum = 1.0f;
+        }
+        for (uint32_t k = 0; k < count; k++) {
+            row[k] /= sum;
+        }
+        result.first_[o] = first;
+        result.count_[o] = count;
+    }
+    return result;
+}
+
+// sRGB texels to premultiplied linear floats, four per texel
+void linearize(const uint8_t* rgba, uint32_t width, float* out) {
+    const auto& linear = tables().linear;
+    for (uint32_t x = 0; x < width; x++) {
+        auto in = rgba + static_cast<size_t>(x) * 4;
+        float a = in[3] / 255.0f;
+#ifdef RESAMPLER_SSE
+        __m128 color = _mm_set_ps(1.0f, linear[in[2]], linear[in[1]], linear[in[0]]);
+        _mm_storeu_ps(out + static_cast<size_t>(x) * 4, _mm_mul_ps(color, _mm_set1_ps(a)));
+#else
+        out[x * 4 + 0] = linear[in[0]] * a;
+        out[x * 4 + 1] = linear[in[1]] * a;
+        out[x * 4 + 2] = linear[in[2]] * a;
+        out[x * 4 + 3] = a;
+#endif
+    }
+}
+
+// sum of weights[k] * rows[k * stride], four floats at a time
+inline void accumulate(const float* rows, size_t stride, const float* weights, uint32_t count, float* out) {
+#ifdef RESAMPLER_SSE
+    __m128 sum = _mm_setzero_ps();
+    for (uint32_t k = 0; k < count; k++) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows + k * stride), _mm_set1_ps(weights[k])));
+    }
+    _mm_storeu_ps(out, sum);
+#else
+    float sum[4] = {};
+    for (uint32_t k = 0; k < count; k++) {
+        for (int c = 0; c < 4; c++) {
+            sum[c] += rows[k * stride + c] * weights[k];
+        }
+    }
+    std::copy_n(sum, 4, out);
+#endif
+}
+
+// premultiplied linear back to sRGB texels
+void encode(const float* in, uint32_t width, uint8_t* rgba) {
+    const auto& srgb = tables().srgb;
+    for (uint32_t x = 0; x < width; x++) {
+        auto texel = in + static_cast<size_t>(x) * 4;
+        auto out = rgba + static_cast<size_t>(x) * 4;
+        // Lanczos rings past the valid range near hard edges
+        float a = std::clamp(texel[3], 0.0f, 1.0f);
+        float unpremultiply = a > 0.0f ? 1.0f / a : 0.0f;
+        for (int c = 0; c < 3; c++) {
+            float value = std::clamp(texel[c] * unpremultiply, 0.0f, 1.0f);
+            out[c] = srgb[static_cast<uint32_t>(value * (srgbSteps - 1) + 0.5f)];
+        }
+        out[3] = static_cast<uint8_t>(a * 255.0f + 0.5f);
+    }
+}
+
+}
+
+std::vector<uint8_t> Resampler::resize(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t outWidth, uint32_t outHeight, Filter filter, uint32_t threads) {
+    if (width == 0 || height == 0 || outWidth == 0 || outHeight == 0) {
+        throw std::runtime_error("can't resample an empty image");
+    }
+    auto horizontal = weights(width, outWidth, filter);
+    auto vertical = weights(height, outHeight, filter);
+
+    std::vector<uint8_t> result(static_cast<size_t>(outWidth) * outHeight * 4);
+    auto bands = (outHeight + bandRows - 1) / bandRows;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    auto worthIt = static_cast<size_t>(outWidth) * outHeight / texelsPerThread;
+    threads = static_cast<uint32_t>(std::max<size_t>(1, std::min<size_t>({threads, bands, worthIt})));
+
+    std::vector<std::exception_ptr> errors(threads);
+    auto work = [&](uint32_t t) {
+        try {
+            std::vector<float> source(static_cast<size_t>(width) * 4);
+            std::vector<float> filtered;
+            std::vector<float> row(static_cast<size_t>(outWidth) * 4);
+            for (uint32_t band = t; band < bands; band += threads) {
+                auto y0 = band * bandRows, y1 = std::min(outHeight, y0 + bandRows);
+                // the source rows this band reads, filtered horizontally once each
+                uint32_t first = UINT32_MAX, last = 0;
+                for (auto y = y0; y < y1; y++) {
+                    first = std::min(first, vertical.first_[y]);
+                    last = std::max(last, vertical.first_[y] + vertical.count_[y]);
+                }
+                size_t stride = static_cast<size_t>(outWidth) * 4;
+                filtered.resize(stride * (last - first));
+                for (auto sy = first; sy < last; sy++) {
+                    linearize(rgba + static_cast<size_t>(sy) * width * 4, width, source.data());
+                    auto out = filtered.data() + stride * (sy - first);
+                    for (uint32_t x = 0; x < outWidth; x++) {
+                        accumulate(source.data() + static_cast<size_t>(horizontal.first_[x]) * 4, 4, &horizontal.weights_[static_cast<size_t>(x) * horizontal.taps_], horizontal.count_[x], out + static_cast<size_t>(x) * 4);
+                    }
+                }
+
+                for (auto y = y0; y < y1; y++) {
+                    auto rows = filtered.data() + stride * (vertical.first_[y] - first);
+                    auto w = &vertical.weights_[static_cast<size_t>(y) * vertical.taps_];
+                    for (uint32_t x = 0; x < outWidth; x++) {
+                        accumulate(rows + static_cast<size_t>(x) * 4, stride, w, vertical.count_[y], row.data() + static_cast<size_t>(x) * 4);
+                    }
+                    encode(row.data(), outWidth, result.data() + static_cast<size_t>(y) * outWidth * 4);
+                }
+            }
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    };
+    // the calling thread takes the first share, small images never start a thread
+    std::vector<std::thread> workers;
+    for (uint32_t t = 1; t < threads; t++) {
+        workers.emplace_back(work, t);
+    }
+    work(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return result;
+}
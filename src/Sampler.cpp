@@ -1,13 +1,14 @@
 #include "Sampler.h"
 #include "vulkan/vulkan_core.h"
 #include "Tools.h"
+#include "HostAllocator.h"
 
 Sampler::Sampler(VkDevice device) : device_(device) {
 
 }
 
 Sampler::~Sampler() {
-    vkDestroySampler(device_, sampler_, nullptr);
+    vkDestroySampler(device_, sampler_, HostAllocator::callbacks(HostAllocator::ObjectType::Sampler));
 }
 
 void Sampler::init() {
@@ -30,5 +31,5 @@ void Sampler::init() {
     samplerInfo.borderColor = borderColor_;
     samplerInfo.unnormalizedCoordinates = unnormalizedCoordinates_;
 
-    VK_CHECK(vkCreateSampler(device_, &samplerInfo, nullptr, &sampler_));
+    VK_CHECK(vkCreateSampler(device_, &samplerInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Sampler), &sampler_));
 }
\ No newline at end of file
@@ -1,13 +1,14 @@
 #include "Semaphore.h"
 #include "vulkan/vulkan_core.h"
 #include "Tools.h"
+#include "HostAllocator.h"
 
 Semaphore::Semaphore(VkDevice device) : device_(device) {
 
 }
 
 Semaphore::~Semaphore() {
-    vkDestroySemaphore(device_, semaphore_, nullptr);
+    vkDestroySemaphore(device_, semaphore_, HostAllocator::callbacks(HostAllocator::ObjectType::Sync));
 }
 
 void Semaphore::init() {
@@ -15,5 +16,5 @@ void Semaphore::init() {
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
     semaphoreInfo.flags = flags_;
     semaphoreInfo.pNext = pNext_;
-    VK_CHECK(vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &semaphore_));
+    VK_CHECK(vkCreateSemaphore(device_, &semaphoreInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Sync), &semaphore_));
 }
\ No newline at end of file
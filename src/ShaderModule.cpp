@@ -4,16 +4,24 @@
 #include "vulkan/vulkan_core.h"
 #include <cstdint>
 #include <stdexcept>
+#include "HostAllocator.h"
 
 ShaderModule::ShaderModule(VkDevice device, const std::string& path) : device_(device) {
     auto code = Tools::readFile(path);
+    create(reinterpret_cast<const uint32_t *>(code.data()), code.size());
+}
 
+ShaderModule::ShaderModule(VkDevice device, const uint32_t* code, size_t size) : device_(device) {
+    create(code, size);
+}
+
+void ShaderModule::create(const uint32_t* code, size_t size) {
     VkShaderModuleCreateInfo shaderInfo{};
     shaderInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    shaderInfo.codeSize = code.size();
-    shaderInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+    shaderInfo.codeSize = size;
+    shaderInfo.pCode = code;
 
-    if (vkCreateShaderModule(device, &shaderInfo, nullptr, &shader_) != VK_SUCCESS) {
+    if (vkCreateShaderModule(device_, &shaderInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Shader), &shader_) != VK_SUCCESS) {
         throw std::runtime_error("failed to create shader!");
     }
 }
\ No newline at end of file
@@ -5,13 +5,22 @@
 #include <cstdint>
 #include <cstdio>
 #include <stdexcept>
+#include "HostAllocator.h"
 
 SwapChain::SwapChain(VkDevice device) : device_(device) {
     
 }
 
 SwapChain::~SwapChain() {
-    vkDestroySwapchainKHR(device_, swapChain_, nullptr);
+    if (offscreen()) {
+        // views belong to the offscreen images
+        return ;
+    }
+
+    for (auto view : imageViews_) {
+        vkDestroyImageView(device_, view, HostAllocator::callbacks(HostAllocator::ObjectType::SwapChain));
+    }
+    vkDestroySwapchainKHR(device_, swapChain_, HostAllocator::callbacks(HostAllocator::ObjectType::SwapChain));
 }
 
 void SwapChain::init() {
@@ -34,7 +43,7 @@ void SwapChain::init() {
     swapChainInfo.presentMode = presentMode_;
     swapChainInfo.clipped = clipped_;
     swapChainInfo.oldSwapchain = oldSwapchain_;
-    VK_CHECK(vkCreateSwapchainKHR(device_, &swapChainInfo, nullptr, &swapChain_));
+    VK_CHECK(vkCreateSwapchainKHR(device_, &swapChainInfo, HostAllocator::callbacks(HostAllocator::ObjectType::SwapChain), &swapChain_));
 
     format_ = swapChainInfo.imageFormat;
     extent_ = swapChainInfo.imageExtent;
@@ -55,8 +64,37 @@ void SwapChain::init() {
 
     for (size_t i = 0; i < images_.size(); i++) {
         viewInfo.image = images_[i];
-        if (vkCreateImageView(device_, &viewInfo, nullptr, &imageViews_[i]) != VK_SUCCESS) {
+        if (vkCreateImageView(device_, &viewInfo, HostAllocator::callbacks(HostAllocator::ObjectType::SwapChain), &imageViews_[i]) != VK_SUCCESS) {
             throw std::runtime_error("failed to creat swap chain image view!");
         }
     }
+}
+
+void SwapChain::initOffscreen(VkPhysicalDevice physicalDevice, MemoryAllocator* allocator) {
+    format_ = imageFormat_;
+    extent_ = imageExtent_;
+
+    for (uint32_t i = 0; i < minImageCount_; i++) {
+        auto image = std::make_unique<Image>(physicalDevice, device_, allocator);
+        image->imageType_ = VK_IMAGE_TYPE_2D;
+        image->format_ = format_;
+        image->extent_ = {extent_.width, extent_.height, 1};
+        image->mipLevles_ = 1;
+        image->arrayLayers_ = imageArrayLayers_;
+        image->samples_ = VK_SAMPLE_COUNT_1_BIT;
+        image->tiling_ = VK_IMAGE_TILING_OPTIMAL;
+        image->usage_ = imageUsage_;
+        image->sharingMode_ = imageSharingMode_;
+        image->queueFamilyIndexCount_ = queueFamilyIndexCount_;
+        image->pQueueFamilyIndices_ = pQueueFamilyIndices_;
+        image->memoryProperties_ = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        image->memoryTag_ = Tools::MemoryTag::Attachments;
+        image->viewType_ = VK_IMAGE_VIEW_TYPE_2D;
+        image->subresourcesRange_ = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        image->init();
+
+        images_.push_back(image->image());
+        imageViews_.push_back(image->view());
+        offscreenImages_.push_back(std::move(image));
+    }
 }
\ No newline at end of file
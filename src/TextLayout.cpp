@@ -0,0 +1,51 @@
+#include "TextLayout.h"
+#include <algorithm>
+
+void TextLayout::update(float x, float y, float scale, const std::u32string& text, const GlyphLookup& glyph) {
+    if (x != x_ || y != y_ || scale != scale_) {
+        invalidate();
+        x_ = x;
+        y_ = y;
+        scale_ = scale;
+    }
+
+    // the common prefix is already laid out
+    auto prefix = static_cast<uint32_t>(std::mismatch(text_.begin(), text_.end(), text.begin(), text.end()).first - text_.begin());
+    if (prefix == text_.size() && prefix == text.size()) {
+        return ;
+    }
+
+    text_.resize(prefix);
+    pens_.resize(prefix + 1);
+    glyphs_.resize(prefix);
+    if (prefix == 0) {
+        pens_[0] = x_;
+    }
+
+    auto pen = pens_[prefix];
+    for (size_t i = prefix; i < text.size(); i++) {
+        auto character = glyph(text[i]);
+        glyphs_.push_back(Font::instance(pen, y_, character, scale_));
+
+        pen += character.advance_ * scale_;
+        pens_.push_back(pen);
+    }
+    text_.append(text, prefix, std::u32string::npos);
+
+    // deleted glyphs aren't drawn anymore, only appended ones need uploading
+    dirtyBegin_ = std::min(dirtyBegin_, prefix);
+    dirtyEnd_ = std::max(dirtyEnd_, static_cast<uint32_t>(text_.size()));
+}
+
+void TextLayout::invalidate() {
+    text_.clear();
+    pens_.clear();
+    glyphs_.clear();
+}
+
+std::pair<uint32_t, uint32_t> TextLayout::takeDirty() {
+    std::pair<uint32_t, uint32_t> dirty(dirtyBegin_, std::min(dirtyEnd_, size()));
+    dirtyBegin_ = UINT32_MAX;
+    dirtyEnd_ = 0;
+    return dirty;
+}
@@ -0,0 +1,94 @@
+#include "TextRaster.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TEXT_RASTER_SSE
+#endif
+
+TextRaster::TextRaster(const GlyphAtlas& atlas, uint32_t spread) : atlas_(atlas), spread_(spread) {}
+
+void TextRaster::glyph(float x, float y, const Font::Character& character, float scale, const std::function<void(int, int, float)>& plot) const {
+    if (character.width_ == 0 || character.height_ == 0) {
+        return ;
+    }
+
+    // the quad Font::instance would draw
+    float left = x + character.offsetX_ * scale;
+    float bottom = y + (character.offsetY_ - static_cast<float>(character.height_)) * scale;
+    float width = character.width_ * scale, height = character.height_ * scale;
+
+    float atlasWidth = static_cast<float>(atlas_.width()), atlasHeight = static_cast<float>(atlas_.height());
+    float u0 = character.uvMin_.x * atlasWidth, u1 = character.uvMax_.x * atlasWidth;
+    float v0 = character.uvMin_.y * atlasHeight, v1 = character.uvMax_.y * atlasHeight;
+
+    // the field changes by 127/255 over spread texels; smooth over about one screen pixel like fwidth does
+    float edge = std::max(0.5f * 127.0f / 255.0f / (spread_ * scale), 1e-4f);
+
+    int x0 = static_cast<int>(std::floor(left)), x1 = static_cast<int>(std::ceil(left + width));
+    int y0 = static_cast<int>(std::floor(bottom)), y1 = static_cast<int>(std::ceil(bottom + height));
+    for (int py = y0; py < y1; py++) {
+        // bitmaps are stored top row first
+        float t = 1.0f - (py + 0.5f - bottom) / height;
+        if (t < 0.0f || t > 1.0f) {
+            continue;
+        }
+        float ty = v0 + t * (v1 - v0);
+        for (int px = x0; px < x1; px++) {
+            float s = (px + 0.5f - left) / width;
+            if (s < 0.0f || s > 1.0f) {
+                continue;
+            }
+            float distance = sample(u0 + s * (u1 - u0), ty);
+            float coverage = std::clamp((distance - (0.5f - edge)) / (2.0f * edge), 0.0f, 1.0f);
+            coverage = coverage * coverage * (3.0f - 2.0f * coverage);
+            if (coverage > 0.0f) {
+                plot(px, py, coverage);
+            }
+        }
+    }
+}
+
+float TextRaster::sample(float x, float y) const {
+    // texel centers sit at half coordinates
+    x -= 0.5f;
+    y -= 0.5f;
+    int width = static_cast<int>(atlas_.width()), height = static_cast<int>(atlas_.height());
+    int ix = static_cast<int>(std::floor(x)), iy = static_cast<int>(std::floor(y));
+    float fx = x - ix, fy = y - iy;
+
+    auto texel = [&](int tx, int ty) {
+        tx = std::clamp(tx, 0, width - 1);
+        ty = std::clamp(ty, 0, height - 1);
+        return atlas_.pixels()[static_cast<size_t>(ty) * width + tx] / 255.0f;
+    };
+    float top = texel(ix, iy) + (texel(ix + 1, iy) - texel(ix, iy)) * fx;
+    float bottom = texel(ix, iy + 1) + (texel(ix + 1, iy + 1) - texel(ix, iy + 1)) * fx;
+    return top + (bottom - top) * fy;
+}
+
+void TextRaster::blendOver(float* dst, const float* src) {
+    float a = src[3], da = dst[3];
+    float outA = a + da * (1.0f - a);
+    if (outA <= 0.0f) {
+        return ;
+    }
+
+#ifdef TEXT_RASTER_SSE
+    // rgb = (src * a + dst * da * (1 - a)) / outA, alpha = outA; all four lanes at once
+    __m128 s = _mm_loadu_ps(src);
+    __m128 d = _mm_loadu_ps(dst);
+    __m128 sw = _mm_set1_ps(a / outA);
+    __m128 dw = _mm_set1_ps(da * (1.0f - a) / outA);
+    __m128 result = _mm_add_ps(_mm_mul_ps(s, sw), _mm_mul_ps(d, dw));
+    _mm_storeu_ps(dst, result);
+    dst[3] = outA;
+#else
+    float sw = a / outA, dw = da * (1.0f - a) / outA;
+    for (int i = 0; i < 3; i++) {
+        dst[i] = src[i] * sw + dst[i] * dw;
+    }
+    dst[3] = outA;
+#endif
+}
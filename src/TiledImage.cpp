@@ -0,0 +1,167 @@
+#include "TiledImage.h"
+#include "Resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+TiledImage::TiledImage(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t tileSize, uint32_t slots, uint32_t maxExtent)
+    : width_(width), height_(height), tileSize_(tileSize), stride_(tileSize - 2 * gutter_), slots_(slots) {
+    if (width == 0 || height == 0 || tileSize <= 2 * gutter_ || slots == 0) {
+        throw std::runtime_error("invalid tiled image");
+    }
+
+    // the finest level a view of maxExtent ever picks is the coarsest one still at least that big
+    uint32_t levelWidth = width, levelHeight = height;
+    auto halve = [](uint32_t size) { return std::max(1u, (size + 1) / 2); };
+    while (std::max(levelWidth, levelHeight) > stride_ && std::max(halve(levelWidth), halve(levelHeight)) >= maxExtent) {
+        levelWidth = halve(levelWidth);
+        levelHeight = halve(levelHeight);
+        firstLevel_++;
+    }
+
+    // one filtered reduction straight to the first kept level, then halvings until one tile holds it
+    std::vector<uint8_t> level;
+    const uint8_t* pixels = rgba;
+    if (firstLevel_ != 0) {
+        level = Resampler::resize(rgba, width, height, levelWidth, levelHeight, Resampler::Filter::Lanczos3);
+        pixels = level.data();
+    }
+    for (;;) {
+        slice(pixels, levelWidth, levelHeight);
+        if (std::max(levelWidth, levelHeight) <= stride_) {
+            break;
+        }
+        auto halfWidth = halve(levelWidth), halfHeight = halve(levelHeight);
+        level = Resampler::resize(pixels, levelWidth, levelHeight, halfWidth, halfHeight, Resampler::Filter::Box);
+        pixels = level.data();
+        levelWidth = halfWidth;
+        levelHeight = halfHeight;
+    }
+}
+
+void TiledImage::slice(const uint8_t* rgba, uint32_t width, uint32_t height) {
+    Level level;
+    level.width_ = width;
+    level.height_ = height;
+    level.columns_ = (width + stride_ - 1) / stride_;
+    level.rows_ = (height + stride_ - 1) / stride_;
+    level.tiles_.resize(static_cast<size_t>(level.columns_) * level.rows_);
+
+    for (uint32_t row = 0; row < level.rows_; row++) {
+        for (uint32_t column = 0; column < level.columns_; column++) {
+            auto& tile = level.tiles_[static_cast<size_t>(row) * level.columns_ + column];
+            tile.resize(static_cast<size_t>(tileSize_) * tileSize_ * 4);
+            // past the image edge the border texels repeat, like clamp-to-edge would
+            auto left = static_cast<int64_t>(column) * stride_ - gutter_;
+            auto top = static_cast<int64_t>(row) * stride_ - gutter_;
+            for (uint32_t y = 0; y < tileSize_; y++) {
+                auto sourceY = static_cast<size_t>(std::clamp<int64_t>(top + y, 0, height - 1));
+                auto source = rgba + sourceY * width * 4;
+                auto out = tile.data() + static_cast<size_t>(y) * tileSize_ * 4;
+                for (uint32_t x = 0; x < tileSize_; x++) {
+                    auto sourceX = static_cast<size_t>(std::clamp<int64_t>(left + x, 0, width - 1));
+                    std::copy_n(source + sourceX * 4, 4, out + static_cast<size_t>(x) * 4);
+                }
+            }
+        }
+    }
+    levels_.push_back(std::move(level));
+}
+
+std::vector<TiledImage::Upload> TiledImage::update(const Rect& view, uint32_t viewWidth, uint32_t viewHeight) {
+    auto visible = [&](const Level& level, uint32_t& column0, uint32_t& row0, uint32_t& column1, uint32_t& row1) {
+        auto cell = [&](float t, uint32_t size, uint32_t cells) {
+            auto texel = std::clamp(t, 0.0f, 1.0f) * static_cast<float>(size);
+            return std::min(static_cast<uint32_t>(texel / static_cast<float>(stride_)), cells - 1);
+        };
+        column0 = cell(view.x0_, level.width_, level.columns_);
+        column1 = cell(view.x1_, level.width_, level.columns_);
+        row0 = cell(view.y0_, level.height_, level.rows_);
+        row1 = cell(view.y1_, level.height_, level.rows_);
+        return (column1 - column0 + 1) * (row1 - row0 + 1);
+    };
+
+    // coarsest level that still has a texel for every pixel of the view, coarser while its tiles
+    // don't fit in the slots
+    auto chosen = static_cast<uint32_t>(levels_.size() - 1);
+    for (uint32_t i = 0; i < levels_.size(); i++) {
+        auto texelsX = (view.x1_ - view.x0_) * static_cast<float>(levels_[i].width_);
+        auto texelsY = (view.y1_ - view.y0_) * static_cast<float>(levels_[i].height_);
+        if (texelsX < static_cast<float>(viewWidth) || texelsY < static_cast<float>(viewHeight)) {
+            chosen = i == 0 ? 0 : i - 1;
+            break;
+        }
+    }
+    uint32_t column0, row0, column1, row1;
+    while (visible(levels_[chosen], column0, row0, column1, row1) > slots_.size() && chosen + 1 < levels_.size()) {
+        chosen++;
+    }
+    if (visible(levels_[chosen], column0, row0, column1, row1) > slots_.size()) {
+        throw std::runtime_error("tiled image has fewer slots than its coarsest level has tiles");
+    }
+
+    const auto& level = levels_[chosen];
+    use_++;
+    std::vector<Upload> uploads;
+    std::vector<uint32_t> missing;
+    for (uint32_t row = row0; row <= row1; row++) {
+        for (uint32_t column = column0; column <= column1; column++) {
+            auto tile = row * level.columns_ + column;
+            auto it = resident_.find(key(chosen, tile));
+            if (it != resident_.end()) {
+                slots_[it->second].lastUse_ = use_;
+            } else {
+                missing.push_back(tile);
+            }
+        }
+    }
+    for (auto tile : missing) {
+        // visible tiles were all stamped with use_ above, the oldest slot is never one of them
+        auto slot = static_cast<uint32_t>(std::min_element(slots_.begin(), slots_.end(), [](const Slot& a, const Slot& b) { return a.lastUse_ < b.lastUse_; }) - slots_.begin());
+        if (slots_[slot].key_ != UINT64_MAX) {
+            resident_.erase(slots_[slot].key_);
+        }
+        slots_[slot].key_ = key(chosen, tile);
+        slots_[slot].lastUse_ = use_;
+        resident_[key(chosen, tile)] = slot;
+        uploads.push_back({slot, level.tiles_[tile].data()});
+    }
+
+    if (chosen == current_ && uploads.empty()) {
+        return uploads;
+    }
+    current_ = chosen;
+    table_.assign(tableHeader_ + level.tiles_.size(), notResident_);
+    table_[0] = level.columns_;
+    table_[1] = level.rows_;
+    table_[2] = level.width_;
+    table_[3] = level.height_;
+    table_[4] = tileSize_;
+    table_[5] = stride_;
+    table_[6] = gutter_;
+    table_[7] = 0;
+    for (const auto& [tileKey, slot] : resident_) {
+        if ((tileKey >> 32) == chosen) {
+            table_[tableHeader_ + static_cast<uint32_t>(tileKey)] = slot;
+        }
+    }
+    tableDirty_ = true;
+    return uploads;
+}
+
+uint32_t TiledImage::maxTableSize() const {
+    return tableHeader_ + static_cast<uint32_t>(levels_.front().tiles_.size());
+}
+
+bool TiledImage::takeTableDirty() {
+    return std::exchange(tableDirty_, false);
+}
+
+size_t TiledImage::hostBytes() const {
+    size_t bytes = 0;
+    for (const auto& level : levels_) {
+        bytes += level.tiles_.size() * static_cast<size_t>(tileSize_) * tileSize_ * 4;
+    }
+    return bytes;
+}
@@ -1,19 +1,31 @@
 #include "Timer.h"
 #include <chrono>
 
-Timer::Timer() : prevTime_(std::chrono::high_resolution_clock::now()), currentTime_(std::chrono::high_resolution_clock::now()) {
+Timer::Timer() : prevTime_(std::chrono::steady_clock::now()), currentTime_(prevTime_) {
 
 }
 
 void Timer::tick() {
     prevTime_ = currentTime_;
-    currentTime_ = std::chrono::high_resolution_clock::now();
+    currentTime_ = std::chrono::steady_clock::now();
+}
+
+unsigned long long Timer::deltaNanoseconds() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(currentTime_ - prevTime_).count();
 }
 
 unsigned long long Timer::deltaMilliseconds() const {
     return std::chrono::duration_cast<std::chrono::milliseconds>(currentTime_ - prevTime_).count();
 }
 
+double Timer::deltaSeconds() const {
+    return std::chrono::duration<double>(currentTime_ - prevTime_).count();
+}
+
 unsigned long long Timer::nowMilliseconds() {
-    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-}
\ No newline at end of file
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+unsigned long long Timer::nowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
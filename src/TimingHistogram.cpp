@@ -0,0 +1,66 @@
+#include "TimingHistogram.h"
+#include <algorithm>
+#include <cmath>
+#include <format>
+
+TimingHistogram::TimingHistogram(size_t capacity, uint64_t budget) : samples_(std::max<size_t>(capacity, 1)), budget_(budget) {
+
+}
+
+void TimingHistogram::record(uint64_t nanoseconds) {
+    samples_[next_] = nanoseconds;
+    next_ = (next_ + 1) % samples_.size();
+    size_ = std::min(size_ + 1, samples_.size());
+
+    total_++;
+    if (budget_ != 0 && nanoseconds > budget_) {
+        totalOverBudget_++;
+    }
+}
+
+void TimingHistogram::reset() {
+    next_ = 0;
+    size_ = 0;
+    total_ = 0;
+    totalOverBudget_ = 0;
+}
+
+TimingHistogram::Stats TimingHistogram::stats() const {
+    Stats stats{};
+    stats.total_ = total_;
+    stats.totalOverBudget_ = totalOverBudget_;
+    if (size_ == 0) {
+        return stats;
+    }
+
+    std::vector<uint64_t> sorted(samples_.begin(), samples_.begin() + size_);
+    std::sort(sorted.begin(), sorted.end());
+
+    // nearest rank
+    auto percentile = [&](double p) {
+        auto rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    };
+    stats.count_ = sorted.size();
+    stats.p50_ = percentile(0.50);
+    stats.p95_ = percentile(0.95);
+    stats.p99_ = percentile(0.99);
+    stats.max_ = sorted.back();
+    if (budget_ != 0) {
+        stats.overBudget_ = sorted.end() - std::upper_bound(sorted.begin(), sorted.end(), budget_);
+    }
+
+    return stats;
+}
+
+std::string TimingHistogram::summary(const std::string& name) const {
+    auto s = stats();
+    auto ms = [](uint64_t nanoseconds) { return nanoseconds / 1e6; };
+    auto summary = std::format("{}: p50 {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms over the last {} samples",
+        name, ms(s.p50_), ms(s.p95_), ms(s.p99_), ms(s.max_), s.count_);
+    // histograms without a budget, like input latency, have nothing to be over
+    if (budget_ != 0) {
+        summary += std::format("; {} of {} over the {:.3f} ms budget", s.totalOverBudget_, s.total_, ms(budget_));
+    }
+    return summary;
+}
@@ -35,6 +35,8 @@
 #include <utility>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
 #define GLM_FORCE_RADIANS
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
@@ -42,20 +44,62 @@
 #include "ShaderModule.h"
 #include "Plane.h"
 #include "Line.h"
+#include "Profiler.h"
+#include "QueryPool.h"
+#include "HostAllocator.h"
+#include "GlyphCache.h"
+#include "TiledImage.h"
 
-Vulkan::Vulkan(const std::string& title, uint32_t width, uint32_t height) : width_(width), height_(height), title_(title) {
+Vulkan::Vulkan(const std::string& title, uint32_t width, uint32_t height, const Config& config) : width_(width), height_(height), title_(title), config_(config) {
     camera_ = std::make_shared<Camera>();
-    initWindow();
+    if (config_.trackHostAllocations_) {
+        HostAllocator::instance().enable(config_.hostArena_);
+    }
+    if (config_.headless_) {
+        deviceExtensions_.clear();
+    } else {
+        initWindow();
+    }
     initVulkan();
+    frameTimes_.setBudget(frameBudget());
+    hostAllocationsAfterInit_ = HostAllocator::instance().allocations();
 }
 
 void Vulkan::run() {
-    while (!glfwWindowShouldClose(windows_)) {
-        glfwPollEvents();
-        draw();
+    if (config_.headless_) {
+        for (uint32_t i = 0; i < config_.headlessFrames_; i++) {
+            draw();
+        }
+        if (!config_.readbackPath_.empty()) {
+            saveFrame(config_.readbackPath_);
+        }
+    } else {
+        while (!glfwWindowShouldClose(windows_)) {
+            if (config_.framePacing_ == Config::FramePacing::Default) {
+                glfwPollEvents();
+            }
+            draw();
+        }
     }
 
     vkDeviceWaitIdle(device_);
+
+    std::cout << frameTimes_.summary("frame time") << std::endl;
+    if (inputLatency_.stats().total_ != 0) {
+        std::cout << inputLatency_.summary("input latency") << std::endl;
+    }
+    if (HostAllocator::instance().enabled()) {
+        auto perFrame = static_cast<double>(HostAllocator::instance().allocations() - hostAllocationsAfterInit_) / std::max<uint64_t>(frameIndex_, 1);
+        std::cout << HostAllocator::instance().summary() << std::endl;
+        std::cout << std::format("{:.1f} host allocations per frame", perFrame) << std::endl;
+    }
+
+#ifdef ENABLE_PROFILER
+    collectTimestamps();
+    if (!Profiler::instance().save(config_.tracePath_)) {
+        std::cerr << std::format("failed to write trace to {}", config_.tracePath_) << std::endl;
+    }
+#endif
 }
 
 void Vulkan::initWindow() {
@@ -67,6 +111,7 @@ void Vulkan::initWindow() {
     windows_ = glfwCreateWindow(width_, height_, title_.c_str(), nullptr, nullptr);
     // glfwSetInputMode(windows_, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     glfwSetWindowUserPointer(windows_, this);
+    glfwSetFramebufferSizeCallback(windows_, frameBufferResizedCallback);
     glfwSetKeyCallback(windows_, [](GLFWwindow* window, int key, int scancode, int action, int mods) {
         int inWindow = glfwGetWindowAttrib(window, GLFW_HOVERED);
         if (!inWindow) {
@@ -117,38 +162,28 @@ void Vulkan::initWindow() {
             return ;
         }
 
-        if (vulkan->inputText_) {
-            if (action == GLFW_PRESS) {
-                char c;
-                if (key == GLFW_KEY_BACKSPACE) {
-                    if (vulkan->text_.size() > 1) {
-                        vulkan->text_.pop_back();
-                    }
-                } else if (key == GLFW_KEY_CAPS_LOCK) {
-                        vulkan->capsLock_ ^= 1;
-                } else if (key >= 0 && key <= 127) {
-                    if (mods == GLFW_MOD_SHIFT) {
-                        c = Tools::charToShiftChar(Tools::keyToChar(key));
-                    } else {
-                        if (!vulkan->capsLock_ && key >= 'A' && key <= 'Z') {
-                            key += 32; 
-                        }
-                        c = Tools::keyToChar(key);
-                    }
-                    if (key != 340) {
-                        vulkan->text_.push_back(c);
-                    }
-                }
+        // the characters themselves arrive through the char callback, already shifted and in any script
+        if (vulkan->inputText_ && key == GLFW_KEY_BACKSPACE && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
+            if (vulkan->text_.size() > 1) {
+                Tools::popUtf8(vulkan->text_);
             }
         }
 
         auto camera = vulkan->camera_;
         camera->onKey(window, key, scancode, action, mods);
     });
+    glfwSetCharCallback(windows_, [](GLFWwindow* window, unsigned int codepoint) {
+        auto vulkan = reinterpret_cast<Vulkan*>(glfwGetWindowUserPointer(window));
+        if (vulkan->inputText_) {
+            Tools::appendUtf8(vulkan->text_, codepoint);
+        }
+    });
     glfwSetCursorPosCallback(windows_, [](GLFWwindow* window, double xpos, double ypos) {
         auto vulkan = reinterpret_cast<Vulkan*>(glfwGetWindowUserPointer(window));
 
         if (vulkan->LeftButton_) {
+            // GLFW hands us no OS event time, so latency starts when glfwPollEvents delivers it
+            vulkan->pendingInputTimes_.push_back(Timer::nowNanoseconds());
             vulkan->ok_ = true;
             if (vulkan->LeftButtonOnce_) {
                 vulkan->LeftButtonOnce_ = false;
@@ -190,6 +225,7 @@ void Vulkan::initWindow() {
             } else {
                 vulkan->ok_ = false;
                 vulkan->LeftButton_ = false;
+                vulkan->pendingInputTimes_.clear();
                 vulkan->LeftButtonOnce_ = false;
                 vulkan->prevCursor_.x = -1;
                 vulkan->prevCursor_.y = -1;
@@ -204,17 +240,19 @@ void Vulkan::initVulkan() {
     createSurface();
     pickPhysicalDevice();
     createLogicDevice();
+    createAllocator();
     createSwapChain();
     createRenderPass();
     createCommandPool();
     createCommandBuffers();
     createUniformBuffers();
+    // the canvas plane decides which tiles of the canvas texture are loaded
+    createVertex();
     loadAssets();
     createSamplers();
     createDescriptorPool();
     createDescriptorSetLayout();
     createDescriptorSet();
-    createVertex();
     createGraphicsPipelines();
     createColorResource();
     createDepthResource();
@@ -222,6 +260,7 @@ void Vulkan::initVulkan() {
     createVertexBuffer();
     createIndexBuffer();
     createSyncObjects();
+    createQueryPool();
 }
 
 void Vulkan::createInstance() {
@@ -238,7 +277,7 @@ void Vulkan::createInstance() {
     appInfo.apiVersion = VK_API_VERSION_1_3;
 
     
-    auto extensions = Tools::getRequiredExtensions();
+    auto extensions = Tools::getRequiredExtensions(config_.headless_);
     VkInstanceCreateInfo creatInfo{};
     VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
     Tools::populateDebugMessengerCreateInfo(debugCreateInfo, debugCallback);
@@ -251,7 +290,7 @@ void Vulkan::createInstance() {
     creatInfo.ppEnabledExtensionNames = extensions.data();
     creatInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*)&debugCreateInfo;
 
-    if (vkCreateInstance(&creatInfo, nullptr, &instance_) != VK_SUCCESS) {
+    if (vkCreateInstance(&creatInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Instance), &instance_) != VK_SUCCESS) {
         throw std::runtime_error("failed to create instance!");
     }
 }
@@ -266,6 +305,10 @@ void Vulkan::setupDebugMessenger() {
 }
 
 void Vulkan::createSurface() {
+    if (config_.headless_) {
+        return ;
+    }
+
     if (glfwCreateWindowSurface(instance_, windows_, nullptr, &surface_) != VK_SUCCESS) {
         throw std::runtime_error("failed to create window surface!");
     }
@@ -285,7 +328,7 @@ void Vulkan::pickPhysicalDevice() {
         vkGetPhysicalDeviceProperties(device, &pro);
         if (deviceSuitable(device)) {
             physicalDevice_ = device;
-            msaaSamples_ = getMaxUsableSampleCount();
+            msaaSamples_ = chooseSampleCount(config_.msaaSamples_);
             break;
         }
     }
@@ -316,11 +359,23 @@ void Vulkan::createLogicDevice() {
     deviceInfo.pQueueCreateInfos = queueInfos.data();
     deviceInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers_.size());
     deviceInfo.ppEnabledLayerNames = validationLayers_.data();
-    deviceInfo.enabledExtensionCount = deviceExtensions_.size();
-    deviceInfo.ppEnabledExtensionNames = deviceExtensions_.data();
+    auto extensions = deviceExtensions_;
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice_, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> avaliables(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice_, nullptr, &extensionCount, avaliables.data());
+    for (const auto& avaliable : avaliables) {
+        if (std::string(avaliable.extensionName) == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) {
+            extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            memoryBudget_ = true;
+        }
+    }
+
+    deviceInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    deviceInfo.ppEnabledExtensionNames = extensions.data();
     deviceInfo.pEnabledFeatures = &features;
 
-    if (vkCreateDevice(physicalDevice_, &deviceInfo, nullptr, &device_) != VK_SUCCESS) {
+    if (vkCreateDevice(physicalDevice_, &deviceInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Device), &device_) != VK_SUCCESS) {
         throw std::runtime_error("failed to create logic device!");
     }
 
@@ -329,18 +384,33 @@ void Vulkan::createLogicDevice() {
     vkGetDeviceQueue(device_, queueFamilies_.transfer.value(), 0, &transferQueue_);
 }
 
-void Vulkan::createSwapChain() {
+void Vulkan::createAllocator() {
+    allocator_ = std::make_unique<MemoryAllocator>(physicalDevice_, device_);
+    allocator_->memoryBudget_ = memoryBudget_;
+}
+
+void Vulkan::createSwapChain(VkSwapchainKHR oldSwapChain) {
+    if (config_.headless_) {
+        auto families = queueFamilies_.sets();
+        swapChain_ = std::make_unique<SwapChain>(device_);
+        swapChain_->minImageCount_ = config_.headlessImageCount_;
+        swapChain_->imageFormat_ = VK_FORMAT_R8G8B8A8_SRGB;
+        swapChain_->imageExtent_ = {width_, height_};
+        swapChain_->imageArrayLayers_ = 1;
+        swapChain_->imageUsage_ = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        swapChain_->imageSharingMode_ = queueFamilies_.sharingMode();
+        swapChain_->queueFamilyIndexCount_ = static_cast<uint32_t>(families.size());
+        swapChain_->pQueueFamilyIndices_ = families.data();
+        swapChain_->initOffscreen(physicalDevice_, allocator_.get());
+        return ;
+    }
+
     auto swapChainSupport = Tools::SwapChainSupportDetail::querySwapChainSupport(physicalDevice_, surface_);
     
     auto surfaceFormat = swapChainSupport.chooseSurfaceFormat();
-    auto presentMode = swapChainSupport.choosePresentMode();
+    auto presentMode = swapChainSupport.choosePresentMode(preferredPresentMode());
     auto extent = swapChainSupport.chooseSwapExtent(windows_);
-    
-    uint32_t imageCount = 0;
-    imageCount = swapChainSupport.capabilities_.minImageCount + 1;
-    if (swapChainSupport.capabilities_.maxImageCount > 0) {
-        imageCount = std::min(imageCount, swapChainSupport.capabilities_.maxImageCount);
-    }
+    auto imageCount = swapChainSupport.chooseImageCount(presentMode);
 
     swapChain_ = std::make_unique<SwapChain>(device_);
     swapChain_->surface_ = surface_;
@@ -357,67 +427,85 @@ void Vulkan::createSwapChain() {
     swapChain_->compositeAlpha_ = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     swapChain_->presentMode_ = presentMode;
     swapChain_->clipped_ = VK_TRUE;
-    swapChain_->oldSwapchain_ = VK_NULL_HANDLE;
+    swapChain_->oldSwapchain_ = oldSwapChain;
     swapChain_->init();
 }
 
 void Vulkan::createRenderPass() {
-    VkAttachmentDescription colorAttachment{}, colorAttachmentResolve{}, depthAttachment{};
+    // headless frames are copied out instead of presented
+    auto outputLayout = config_.headless_ ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
+    // without MSAA the swapchain image is rendered to directly and there is nothing to resolve
+    std::vector<VkAttachmentDescription> attachment;
+    VkAttachmentReference colorAttachmentRef{}, colorAttachmentResolveRef{}, depthAttachmentRef{};
+
+    VkAttachmentDescription colorAttachment{};
     colorAttachment.format = swapChain_->format();
     colorAttachment.samples = msaaSamples_;
     colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    // the multisampled image only lives until it is resolved, let tilers keep it on chip
+    colorAttachment.storeOp = multisampled() ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    colorAttachmentResolve.format = swapChain_->format();
-    colorAttachmentResolve.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachmentResolve.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachmentResolve.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    depthAttachment.format = findDepthFormat();
-    depthAttachment.samples = msaaSamples_;
-    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    colorAttachment.finalLayout = multisampled() ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : outputLayout;
 
-    VkAttachmentReference colorAttachmentRef{}, colorAttachmentResolveRef{}, depthAttachmentRef{};
-    
-    colorAttachmentRef.attachment = 0;
+    colorAttachmentRef.attachment = static_cast<uint32_t>(attachment.size());
     colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachment.push_back(colorAttachment);
+
+    if (multisampled()) {
+        VkAttachmentDescription colorAttachmentResolve{};
+        colorAttachmentResolve.format = swapChain_->format();
+        colorAttachmentResolve.samples = VK_SAMPLE_COUNT_1_BIT;
+        colorAttachmentResolve.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        colorAttachmentResolve.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        colorAttachmentResolve.finalLayout = outputLayout;
+
+        colorAttachmentResolveRef.attachment = static_cast<uint32_t>(attachment.size());
+        colorAttachmentResolveRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachment.push_back(colorAttachmentResolve);
+    }
 
-    colorAttachmentResolveRef.attachment = 1;
-    colorAttachmentResolveRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    depthAttachmentRef.attachment = 2;
-    depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    if (config_.depthAttachment_) {
+        VkAttachmentDescription depthAttachment{};
+        depthAttachment.format = findDepthFormat();
+        depthAttachment.samples = msaaSamples_;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        depthAttachmentRef.attachment = static_cast<uint32_t>(attachment.size());
+        depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        attachment.push_back(depthAttachment);
+    }
 
     VkSubpassDescription subpass{};
     subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = &colorAttachmentRef;
-    subpass.pResolveAttachments = &colorAttachmentResolveRef;
-    subpass.pDepthStencilAttachment = &depthAttachmentRef;
+    subpass.pResolveAttachments = multisampled() ? &colorAttachmentResolveRef : nullptr;
+    subpass.pDepthStencilAttachment = config_.depthAttachment_ ? &depthAttachmentRef : nullptr;
 
     VkSubpassDependency subpassDependency{};
     subpassDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
     subpassDependency.dstSubpass = 0;
-    subpassDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-    subpassDependency.srcAccessMask =  VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-    subpassDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    subpassDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-    std::vector<VkAttachmentDescription> attachment{colorAttachment, colorAttachmentResolve, depthAttachment};
+    subpassDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    subpassDependency.srcAccessMask =  VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    subpassDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    subpassDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    if (config_.depthAttachment_) {
+        subpassDependency.srcStageMask |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        subpassDependency.srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        subpassDependency.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        subpassDependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    }
 
     renderPass_ = std::make_unique<RenderPass>(device_);
     renderPass_->subpassCount_ = 1;
@@ -432,23 +520,33 @@ void Vulkan::createRenderPass() {
 void Vulkan::createUniformBuffers() {
     auto size = sizeof(UniformBufferObject);
 
-    uniformBuffers_ = std::make_unique<Buffer>(physicalDevice_, device_);
+    uniformBuffers_ = std::make_unique<Buffer>(physicalDevice_, device_, allocator_.get());
     uniformBuffers_->size_ = size;
     uniformBuffers_->usage_ = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
     uniformBuffers_->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
     uniformBuffers_->pQueueFamilyIndices_ = queueFamilies_.sets().data();
     uniformBuffers_->memoryProperties_ = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    uniformBuffers_->memoryUsage_ = Tools::MemoryUsage::Dynamic;
+    uniformBuffers_->memoryTag_ = Tools::MemoryTag::Uniforms;
     uniformBuffers_->sharingMode_ = VK_SHARING_MODE_EXCLUSIVE;
     uniformBuffers_->init();
 
     uniformBuffers_->map(size);
 
-    canvasUniformBuffer_ = std::make_unique<Buffer>(physicalDevice_, device_);
+    createCanvasUniformBuffer();
+}
+
+void Vulkan::createCanvasUniformBuffer() {
+    auto size = sizeof(UniformBufferObject);
+
+    canvasUniformBuffer_ = std::make_unique<Buffer>(physicalDevice_, device_, allocator_.get());
     canvasUniformBuffer_->size_ = size;
     canvasUniformBuffer_->usage_ = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
     canvasUniformBuffer_->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
     canvasUniformBuffer_->pQueueFamilyIndices_ = queueFamilies_.sets().data();
     canvasUniformBuffer_->memoryProperties_ = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    canvasUniformBuffer_->memoryUsage_ = Tools::MemoryUsage::Dynamic;
+    canvasUniformBuffer_->memoryTag_ = Tools::MemoryTag::Uniforms;
     canvasUniformBuffer_->sharingMode_ = VK_SHARING_MODE_EXCLUSIVE;
     canvasUniformBuffer_->init();
     auto data = canvasUniformBuffer_->map(sizeof(UniformBufferObject));
@@ -459,17 +557,8 @@ void Vulkan::createUniformBuffers() {
 }
 
 void Vulkan::createSamplers() {
-    brushSampler_ = std::make_unique<Sampler>(device_);
-    brushSampler_->addressModeU_ = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    brushSampler_->addressModeV_ = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    brushSampler_->addressModeW_ = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    brushSampler_->minLod_ = 0.0f;
-    brushSampler_->maxLod_ = 1.0f;
     VkPhysicalDeviceProperties properties;
     vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
-    brushSampler_->anisotropyEnable_ = VK_TRUE;
-    brushSampler_->maxAnisotropy_ = properties.limits.maxSamplerAnisotropy;
-    brushSampler_->init();
 
     canvasSampler_ = std::make_unique<Sampler>(device_);
     canvasSampler_->addressModeU_ = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
@@ -489,11 +578,9 @@ void Vulkan::createDescriptorPool() {
 }
 
 void Vulkan::createBrushDescriptorPool() {
-    std::vector<VkDescriptorPoolSize> poolSizes(2);
+    std::vector<VkDescriptorPoolSize> poolSizes(1);
     poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
     poolSizes[0].descriptorCount = 1;
-    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = 1;
 
     brushDescriptorPool_ = std::make_unique<DescriptorPool>(device_);
     brushDescriptorPool_->poolSizeCount_ = static_cast<uint32_t>(poolSizes.size());
@@ -507,7 +594,7 @@ void Vulkan::createTextDescriptorPool() {
     poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
     poolSizes[0].descriptorCount = 1;
     poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = static_cast<uint32_t>(dictionary_.size());
+    poolSizes[1].descriptorCount = 1;
 
     fontDescriptorPool_ = std::make_unique<DescriptorPool>(device_);
     fontDescriptorPool_->poolSizeCount_ = static_cast<uint32_t>(poolSizes.size());
@@ -517,17 +604,21 @@ void Vulkan::createTextDescriptorPool() {
 }
 
 void Vulkan::createCanvasDescriptorPool() {
-    std::vector<VkDescriptorPoolSize> poolSizes(2);
+    // the live set plus ones replaced by texture loads that the GPU may still be reading
+    const uint32_t maxSets = 4;
+    std::vector<VkDescriptorPoolSize> poolSizes(3);
     poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSizes[0].descriptorCount = 1;
+    poolSizes[0].descriptorCount = maxSets;
     poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = 1;
+    poolSizes[1].descriptorCount = maxSets;
+    poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[2].descriptorCount = maxSets;
 
     canvasDescriptorPool_ = std::make_unique<DescriptorPool>(device_);
     canvasDescriptorPool_->flags_ = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
     canvasDescriptorPool_->poolSizeCount_ = static_cast<uint32_t>(poolSizes.size());
     canvasDescriptorPool_->pPoolSizes_ = poolSizes.data();
-    canvasDescriptorPool_->maxSets_ = 1;
+    canvasDescriptorPool_->maxSets_ = maxSets;
     canvasDescriptorPool_->init();
 }
 
@@ -538,18 +629,14 @@ void Vulkan::createDescriptorSetLayout() {
 }
 
 void Vulkan::createBrushDescriptorSetLayout() {
-    VkDescriptorSetLayoutBinding uboBinding{}, samplerBinding{};
+    // strokes only read the projection; the canvas under them is a separate draw
+    VkDescriptorSetLayoutBinding uboBinding{};
     uboBinding.binding = 0;
     uboBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
     uboBinding.descriptorCount = 1;
     uboBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
-    samplerBinding.binding = 1;
-    samplerBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    samplerBinding.descriptorCount = 1;
-    samplerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-    std::vector<VkDescriptorSetLayoutBinding> bindings = {uboBinding, samplerBinding};
+    std::vector<VkDescriptorSetLayoutBinding> bindings = {uboBinding};
 
     brushDescriptorSetLayout_ = std::make_unique<DescriptorSetLayout>(device_);
     brushDescriptorSetLayout_->bindingCount_ = static_cast<uint32_t>(bindings.size());
@@ -569,7 +656,13 @@ void Vulkan::createTextDescriptorSetLayout() {
     samplerBinding.descriptorCount = 1;
     samplerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
-    std::vector<VkDescriptorSetLayoutBinding> bindings = {uboBinding, samplerBinding};
+    VkDescriptorSetLayoutBinding tileTableBinding{};
+    tileTableBinding.binding = 2;
+    tileTableBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    tileTableBinding.descriptorCount = 1;
+    tileTableBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings = {uboBinding, samplerBinding, tileTableBinding};
 
     canvasDescriptorSetLayout_ = std::make_unique<DescriptorSetLayout>(device_);
     canvasDescriptorSetLayout_->bindingCount_ = static_cast<uint32_t>(bindings.size());
@@ -586,7 +679,7 @@ void Vulkan::createCanvasDescriptorSetLayout() {
 
     samplerBinding.binding = 1;
     samplerBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    samplerBinding.descriptorCount = dictionary_.size();
+    samplerBinding.descriptorCount = 1;
     samplerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
     std::vector<VkDescriptorSetLayoutBinding> bindings = {uboBinding, samplerBinding};
@@ -616,17 +709,17 @@ void Vulkan::createBrushDescriptorSet() {
         throw std::runtime_error("failed to allocate descriptor sets!");
     }
 
+    writeBrushDescriptorSet();
+}
+
+// rewrites the set in place, for when the resources behind it move
+void Vulkan::writeBrushDescriptorSet() {
     VkDescriptorBufferInfo bufferInfo{};
     bufferInfo.buffer = uniformBuffers_->buffer();
     bufferInfo.offset = 0;
     bufferInfo.range = sizeof(UniformBufferObject);
 
-    VkDescriptorImageInfo samplerInfo{};
-    samplerInfo.imageView = canvasImage_->view();
-    samplerInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    samplerInfo.sampler = brushSampler_->sampler();
-
-    std::vector<VkWriteDescriptorSet> descriptorWrites(2);
+    std::vector<VkWriteDescriptorSet> descriptorWrites(1);
     descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     descriptorWrites[0].dstSet = brushDescriptorSets_;
     descriptorWrites[0].dstBinding = 0;
@@ -634,13 +727,6 @@ void Vulkan::createBrushDescriptorSet() {
     descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
     descriptorWrites[0].pBufferInfo = &bufferInfo;
 
-    descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorWrites[1].dstSet = brushDescriptorSets_;
-    descriptorWrites[1].dstBinding = 1;
-    descriptorWrites[1].descriptorCount = 1;
-    descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descriptorWrites[1].pImageInfo = &samplerInfo;
-
     vkUpdateDescriptorSets(device_, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 }
 
@@ -657,19 +743,19 @@ void Vulkan::createTextDescriptorSet() {
         throw std::runtime_error("failed to allocate descriptor sets!");
     }
 
+    writeTextDescriptorSet();
+}
+
+void Vulkan::writeTextDescriptorSet() {
     VkDescriptorBufferInfo bufferInfo{};
     bufferInfo.buffer = uniformBuffers_->buffer();
     bufferInfo.offset = 0;
     bufferInfo.range = sizeof(UniformBufferObject);
 
-    
-    std::vector<VkDescriptorImageInfo> imageInfos(dictionary_.size());
-    for (uint32_t i = 0; i < 128; i++) {
-        char c = static_cast<char>(i);
-        imageInfos[i].imageView = dictionary_[c].image_->view();
-        imageInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfos[i].sampler = canvasSampler_->sampler();
-    }
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.imageView = glyphAtlasImage_->view();
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.sampler = canvasSampler_->sampler();
 
     std::vector<VkWriteDescriptorSet> descriptorWrites(2);
     descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -682,8 +768,8 @@ void Vulkan::createTextDescriptorSet() {
     descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     descriptorWrites[1].dstSet = fontDescriptorSet_;
     descriptorWrites[1].dstBinding = 1;
-    descriptorWrites[1].descriptorCount = static_cast<uint32_t>(imageInfos.size());
-    descriptorWrites[1].pImageInfo = imageInfos.data();
+    descriptorWrites[1].descriptorCount = 1;
+    descriptorWrites[1].pImageInfo = &imageInfo;
     descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 
     vkUpdateDescriptorSets(device_, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
@@ -699,10 +785,16 @@ void Vulkan::createCanvasDescriptorSet() {
     allocateInfo.pSetLayouts = descriptorSetLayouts.data();
 
     if (canvasDescriptorSets_ != VK_NULL_HANDLE) {
-        VK_CHECK(vkFreeDescriptorSets(device_, canvasDescriptorPool_->descriptorPool(), 1, &canvasDescriptorSets_));
+        retire([device = device_, pool = canvasDescriptorPool_->descriptorPool(), set = canvasDescriptorSets_]() {
+            VK_CHECK(vkFreeDescriptorSets(device, pool, 1, &set));
+        });
     }
     VK_CHECK(vkAllocateDescriptorSets(device_, &allocateInfo, &canvasDescriptorSets_));
 
+    writeCanvasDescriptorSet();
+}
+
+void Vulkan::writeCanvasDescriptorSet() {
     VkDescriptorBufferInfo bufferInfo{};
     bufferInfo.buffer = uniformBuffers_->buffer();
     bufferInfo.offset = 0;
@@ -713,7 +805,12 @@ void Vulkan::createCanvasDescriptorSet() {
     samplerInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     samplerInfo.sampler = canvasSampler_->sampler();
 
-    std::vector<VkWriteDescriptorSet> descriptorWrites(2);
+    VkDescriptorBufferInfo tileTableInfo{};
+    tileTableInfo.buffer = canvasTileTable_->buffer();
+    tileTableInfo.offset = 0;
+    tileTableInfo.range = VK_WHOLE_SIZE;
+
+    std::vector<VkWriteDescriptorSet> descriptorWrites(3);
     descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     descriptorWrites[0].dstSet = canvasDescriptorSets_;
     descriptorWrites[0].dstBinding = 0;
@@ -728,6 +825,13 @@ void Vulkan::createCanvasDescriptorSet() {
     descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     descriptorWrites[1].pImageInfo = &samplerInfo;
 
+    descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[2].dstSet = canvasDescriptorSets_;
+    descriptorWrites[2].dstBinding = 2;
+    descriptorWrites[2].descriptorCount = 1;
+    descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorWrites[2].pBufferInfo = &tileTableInfo;
+
     vkUpdateDescriptorSets(device_, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 }
 
@@ -755,13 +859,16 @@ void Vulkan::createVertex() {
     }
 
     {
-        font_ = std::make_unique<Font>(fontPath_.c_str(), 48);
+        // only describes the text pipeline's vertex input, a resize keeps it
+        if (!font_) {
+            font_ = std::make_unique<Font>(fontManager_.library(), fontManager_.face(config_.fontPath_), config_.fontBaseSize_);
+        }
     }
 }
 
 void Vulkan::createBrushPipeline() {
-    auto vertBrush = ShaderModule(device_, "../shaders/spv/VertBrush.spv"); 
-    auto fragBrush = ShaderModule(device_, "../shaders/spv/FragBrush.spv");
+    auto vertBrush = loadShader("VertBrush.spv"); 
+    auto fragBrush = loadShader("FragBrush.spv");
 
     VkPipelineShaderStageCreateInfo vertexStageInfo{}, fragmentStageInfo{};
     vertexStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -854,7 +961,7 @@ void Vulkan::createBrushPipeline() {
     brushPipeline_->pViewportState_ = &viewportInfo;
     brushPipeline_->pRasterizationState_ = &rasterizaInfo;;
     brushPipeline_->pMultisampleState_ = &multipleInfo;
-    brushPipeline_->pDepthStencilState_ = &depthStencilInfo;
+    brushPipeline_->pDepthStencilState_ = config_.depthAttachment_ ? &depthStencilInfo : nullptr;
     brushPipeline_->pColorBlendState_ = &colorBlendInfo;
     brushPipeline_->pDynamicState_ = &dynamicInfo;
     brushPipeline_->layout_ = brushPipelineLayout_->pipelineLayout();
@@ -863,8 +970,8 @@ void Vulkan::createBrushPipeline() {
 }
 
 void Vulkan::createTextPipeline() {
-    auto vertFont = ShaderModule(device_, "../shaders/spv/VertFont.spv"); 
-    auto fragFont = ShaderModule(device_, "../shaders/spv/FragFont.spv");
+    auto vertFont = loadShader("VertFont.spv"); 
+    auto fragFont = loadShader("FragFont.spv");
 
     VkPipelineShaderStageCreateInfo vertexStageInfo{}, fragmentStageInfo{};
     vertexStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -957,7 +1064,7 @@ void Vulkan::createTextPipeline() {
     fontPipeline_->pViewportState_ = &viewportInfo;
     fontPipeline_->pRasterizationState_ = &rasterizaInfo;;
     fontPipeline_->pMultisampleState_ = &multipleInfo;
-    fontPipeline_->pDepthStencilState_ = &depthStencilInfo;
+    fontPipeline_->pDepthStencilState_ = config_.depthAttachment_ ? &depthStencilInfo : nullptr;
     fontPipeline_->pColorBlendState_ = &colorBlendInfo;
     fontPipeline_->pDynamicState_ = &dynamicInfo;
     fontPipeline_->layout_ = fontPipelineLayout_->pipelineLayout();
@@ -966,8 +1073,8 @@ void Vulkan::createTextPipeline() {
 }
 
 void Vulkan::createCanvasPipeline() {
-    auto vertCanvas = ShaderModule(device_, "../shaders/spv/VertCanvas.spv");
-    auto fragCanvas = ShaderModule(device_, "../shaders/spv/FragCanvas.spv");
+    auto vertCanvas = loadShader("VertCanvas.spv");
+    auto fragCanvas = loadShader("FragCanvas.spv");
 
     VkPipelineShaderStageCreateInfo vertexStageInfo{}, fragmentStageInfo{};
     vertexStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -1060,7 +1167,7 @@ void Vulkan::createCanvasPipeline() {
     canvasPipeline_->pViewportState_ = &viewportInfo;
     canvasPipeline_->pRasterizationState_ = &rasterizaInfo;;
     canvasPipeline_->pMultisampleState_ = &multipleInfo;
-    canvasPipeline_->pDepthStencilState_ = &depthStencilInfo;
+    canvasPipeline_->pDepthStencilState_ = config_.depthAttachment_ ? &depthStencilInfo : nullptr;
     canvasPipeline_->pColorBlendState_ = &colorBlendInfo;
     canvasPipeline_->pDynamicState_ = &dynamicInfo;
     canvasPipeline_->layout_ = canvasPipelineLayout_->pipelineLayout();
@@ -1075,7 +1182,12 @@ void Vulkan::createGraphicsPipelines() {
 }
 
 void Vulkan::createColorResource() {
-    colorImage_ = std::make_unique<Image>(physicalDevice_, device_);
+    if (!multisampled()) {
+        colorImage_.reset();
+        return ;
+    }
+
+    colorImage_ = std::make_unique<Image>(physicalDevice_, device_, allocator_.get());
     colorImage_->imageType_ = VK_IMAGE_TYPE_2D;
     colorImage_->format_ = swapChain_->format();
     colorImage_->extent_ = {swapChain_->extent().width, swapChain_->extent().height, 1};
@@ -1083,19 +1195,26 @@ void Vulkan::createColorResource() {
     colorImage_->arrayLayers_ = 1;
     colorImage_->samples_ = msaaSamples_;
     colorImage_->tiling_ = VK_IMAGE_TILING_OPTIMAL;
-    colorImage_->usage_ = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    colorImage_->usage_ = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
     colorImage_->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
     colorImage_->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
     colorImage_->pQueueFamilyIndices_ = queueFamilies_.sets().data();
     colorImage_->viewType_ = VK_IMAGE_VIEW_TYPE_2D;
     colorImage_->subresourcesRange_ = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
     colorImage_->memoryProperties_ = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    colorImage_->preferredMemoryProperties_ = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+    colorImage_->memoryTag_ = Tools::MemoryTag::Attachments;
 
     colorImage_->init();
 }
 
 void Vulkan::createDepthResource() {
-    depthImage_ = std::make_unique<Image>(physicalDevice_, device_);
+    if (!config_.depthAttachment_) {
+        depthImage_.reset();
+        return ;
+    }
+
+    depthImage_ = std::make_unique<Image>(physicalDevice_, device_, allocator_.get());
     depthImage_->imageType_ = VK_IMAGE_TYPE_2D;
     depthImage_->format_ = findDepthFormat();
     depthImage_->mipLevles_ = 1;
@@ -1103,13 +1222,15 @@ void Vulkan::createDepthResource() {
     depthImage_->samples_ = msaaSamples_;
     depthImage_->extent_ = {swapChain_->extent().width, swapChain_->extent().height, 1};
     depthImage_->tiling_ = VK_IMAGE_TILING_OPTIMAL;
-    depthImage_->usage_ = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    depthImage_->usage_ = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
     depthImage_->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
     depthImage_->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
     depthImage_->pQueueFamilyIndices_ = queueFamilies_.sets().data();
     depthImage_->viewType_ = VK_IMAGE_VIEW_TYPE_2D;
     depthImage_->subresourcesRange_ = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1};
     depthImage_->memoryProperties_ = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    depthImage_->preferredMemoryProperties_ = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+    depthImage_->memoryTag_ = Tools::MemoryTag::Attachments;
 
     depthImage_->init();
 }
@@ -1118,11 +1239,14 @@ void Vulkan::createFrameBuffer() {
     frameBuffers_.resize(swapChain_->size());
     
     for (size_t i = 0; i < frameBuffers_.size(); i++) {
-        std::vector<VkImageView> attachment = {
-            colorImage_->view(), 
-            swapChain_->imageView(i), 
-            depthImage_->view(),   
-        };
+        std::vector<VkImageView> attachment;
+        if (multisampled()) {
+            attachment.push_back(colorImage_->view());
+        }
+        attachment.push_back(swapChain_->imageView(i));
+        if (config_.depthAttachment_) {
+            attachment.push_back(depthImage_->view());
+        }
 
         frameBuffers_[i] = std::make_unique<FrameBuffer>(device_);
         frameBuffers_[i]->renderPass_ = renderPass_->renderPass();
@@ -1140,6 +1264,11 @@ void Vulkan::createCommandPool() {
     commandPool_->flags_ = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     commandPool_->queueFamilyIndex_ = queueFamilies_.graphics.value();
     commandPool_->init();
+
+    transferCommandPool_ = std::make_unique<CommandPool>(device_);
+    transferCommandPool_->flags_ = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    transferCommandPool_->queueFamilyIndex_ = queueFamilies_.transfer.value();
+    transferCommandPool_->init();
 }
 
 void Vulkan::createCommandBuffers() {
@@ -1154,60 +1283,37 @@ void Vulkan::createVertexBuffer() {
     {
         VkDeviceSize size = sizeof(canvasVertices_[0]) * canvasVertices_.size();
 
-        canvasVertexBuffer_ = std::make_unique<Buffer>(physicalDevice_, device_);
+        canvasVertexBuffer_ = std::make_unique<Buffer>(physicalDevice_, device_, allocator_.get());
         canvasVertexBuffer_->size_ = size;
-        canvasVertexBuffer_->usage_ = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+        canvasVertexBuffer_->usage_ = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
         canvasVertexBuffer_->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
         canvasVertexBuffer_->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
         canvasVertexBuffer_->pQueueFamilyIndices_ = queueFamilies_.sets().data();
         canvasVertexBuffer_->memoryProperties_ = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        canvasVertexBuffer_->memoryUsage_ = Tools::MemoryUsage::GpuOnly;
+        canvasVertexBuffer_->memoryTag_ = Tools::MemoryTag::Vertices;
         canvasVertexBuffer_->init();
 
-        std::unique_ptr<Buffer> staginBuffer = std::make_unique<Buffer>(physicalDevice_, device_);
-        staginBuffer->size_ = size;
-        staginBuffer->usage_ = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        staginBuffer->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
-        staginBuffer->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
-        staginBuffer->pQueueFamilyIndices_ = queueFamilies_.sets().data();
-        staginBuffer->memoryProperties_ = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-        staginBuffer->init();
-
-        auto data = staginBuffer->map(size);
-        memcpy(data, canvasVertices_.data(), size);
-        staginBuffer->unMap();
-
-        copyBuffer(staginBuffer->buffer(), canvasVertexBuffer_->buffer(), size);
+        upload(*canvasVertexBuffer_, canvasVertices_.data(), size);
     }
 
     {
         VkDeviceSize size = sizeof(Line::Point) * lineVertices_.size();
 
-        lineVertexBuffers_ = std::make_unique<Buffer>(physicalDevice_, device_);
+        lineVertexBuffers_ = std::make_unique<Buffer>(physicalDevice_, device_, allocator_.get());
         if (size == 0) {
             return ;
         }
         lineVertexBuffers_->size_ = size;
-        lineVertexBuffers_->usage_ = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        lineVertexBuffers_->usage_ = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
         lineVertexBuffers_->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
         lineVertexBuffers_->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
         lineVertexBuffers_->pQueueFamilyIndices_ = queueFamilies_.sets().data();
-        lineVertexBuffers_->memoryProperties_ = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        lineVertexBuffers_->memoryUsage_ = Tools::MemoryUsage::Dynamic;
+        lineVertexBuffers_->memoryTag_ = Tools::MemoryTag::Vertices;
         lineVertexBuffers_->init();
 
-        auto staginBuffer = std::make_unique<Buffer>(physicalDevice_, device_);
-        staginBuffer->size_ = size;
-        staginBuffer->usage_ = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        staginBuffer->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
-        staginBuffer->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
-        staginBuffer->pQueueFamilyIndices_ = queueFamilies_.sets().data();
-        staginBuffer->memoryProperties_ = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-        staginBuffer->init();
-
-        auto data = staginBuffer->map(size);
-        memcpy(data, lineVertices_.data(), size);
-        staginBuffer->unMap();
-
-        copyBuffer(staginBuffer->buffer(), lineVertexBuffers_->buffer(), size);
+        upload(*lineVertexBuffers_, lineVertices_.data(), size);
     }
 }
 
@@ -1215,60 +1321,38 @@ void Vulkan::createIndexBuffer() {
     {
         VkDeviceSize size = sizeof(canvasIndices_[0]) * canvasIndices_.size();
 
-        canvasIndexBuffer_ = std::make_unique<Buffer>(physicalDevice_, device_);
+        canvasIndexBuffer_ = std::make_unique<Buffer>(physicalDevice_, device_, allocator_.get());
         canvasIndexBuffer_->size_ = size;
-        canvasIndexBuffer_->usage_ = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+        canvasIndexBuffer_->usage_ = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
         canvasIndexBuffer_->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
         canvasIndexBuffer_->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
         canvasIndexBuffer_->pQueueFamilyIndices_ = queueFamilies_.sets().data();
         canvasIndexBuffer_->memoryProperties_ = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        canvasIndexBuffer_->memoryUsage_ = Tools::MemoryUsage::GpuOnly;
+        canvasIndexBuffer_->memoryTag_ = Tools::MemoryTag::Vertices;
         canvasIndexBuffer_->init();
 
-        std::unique_ptr<Buffer> staginBuffer = std::make_unique<Buffer>(physicalDevice_, device_);
-        staginBuffer->size_ = size;
-        staginBuffer->usage_ = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        staginBuffer->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
-        staginBuffer->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
-        staginBuffer->pQueueFamilyIndices_ = queueFamilies_.sets().data();
-        staginBuffer->memoryProperties_ = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-        staginBuffer->init();
-
-        auto data = staginBuffer->map(size);
-        memcpy(data, canvasIndices_.data(), size);
-        staginBuffer->unMap();
-
-        copyBuffer(staginBuffer->buffer(), canvasIndexBuffer_->buffer(), size);
+        upload(*canvasIndexBuffer_, canvasIndices_.data(), size);
     }
     
     {
         VkDeviceSize size = sizeof(lineIndices_[0]) * lineIndices_.size();
 
-        lineIndexBuffers_ = std::make_unique<Buffer>(physicalDevice_, device_);
+        lineIndexBuffers_ = std::make_unique<Buffer>(physicalDevice_, device_, allocator_.get());
         if (size == 0) {
             return ;
         }
         lineIndexBuffers_->size_ = size;
-        lineIndexBuffers_->usage_ = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        lineIndexBuffers_->usage_ = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
         lineIndexBuffers_->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
         lineIndexBuffers_->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
         lineIndexBuffers_->pQueueFamilyIndices_ = queueFamilies_.sets().data();
         lineIndexBuffers_->memoryProperties_ = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        lineIndexBuffers_->memoryUsage_ = Tools::MemoryUsage::GpuOnly;
+        lineIndexBuffers_->memoryTag_ = Tools::MemoryTag::Vertices;
         lineIndexBuffers_->init();
 
-        std::unique_ptr<Buffer> staginBuffer = std::make_unique<Buffer>(physicalDevice_, device_);
-        staginBuffer->size_ = size;
-        staginBuffer->usage_ = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        staginBuffer->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
-        staginBuffer->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
-        staginBuffer->pQueueFamilyIndices_ = queueFamilies_.sets().data();
-        staginBuffer->memoryProperties_ = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-        staginBuffer->init();
-
-        auto data = staginBuffer->map(size);
-        memcpy(data, lineIndices_.data(), size);
-        staginBuffer->unMap();
-
-        copyBuffer(staginBuffer->buffer(), lineIndexBuffers_->buffer(), size);
+        upload(*lineIndexBuffers_, lineIndices_.data(), size);
     }
 }
 
@@ -1287,9 +1371,233 @@ void Vulkan::createSyncObjects() {
     imageAvaiableSemaphores_->init();
     renderFinishSemaphores_ = std::make_unique<Semaphore>(device_);
     renderFinishSemaphores_->init();
+
+    textureUploadFence_ = std::make_unique<Fence>(device_);
+    textureUploadFence_->init();
+    textureUploadSemaphore_ = std::make_unique<Semaphore>(device_);
+    textureUploadSemaphore_->init();
+}
+
+void Vulkan::createQueryPool() {
+#ifdef ENABLE_PROFILER
+    uint32_t count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(count);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &count, families.data());
+
+    auto validBits = families[queueFamilies_.graphics.value()].timestampValidBits;
+    if (validBits == 0) {
+        std::cerr << "graphics queue has no timestamp support, GPU passes won't be traced" << std::endl;
+        return ;
+    }
+    timestampMask_ = validBits >= 64 ? UINT64_MAX : (uint64_t(1) << validBits) - 1;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+    timestampPeriod_ = properties.limits.timestampPeriod;
+
+    timestampQueryPool_ = std::make_unique<QueryPool>(device_);
+    timestampQueryPool_->queryType_ = VK_QUERY_TYPE_TIMESTAMP;
+    timestampQueryPool_->queryCount_ = TimestampQueryCount;
+    timestampQueryPool_->init();
+#endif
+}
+
+void Vulkan::beginTimestamps(VkCommandBuffer commandBuffer) {
+#ifdef ENABLE_PROFILER
+    if (!timestampQueryPool_) {
+        return ;
+    }
+    vkCmdResetQueryPool(commandBuffer, timestampQueryPool_->queryPool(), 0, TimestampQueryCount);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool_->queryPool(), FrameBegin);
+#endif
+}
+
+void Vulkan::writeTimestamp(VkCommandBuffer commandBuffer, uint32_t query) {
+#ifdef ENABLE_PROFILER
+    if (!timestampQueryPool_) {
+        return ;
+    }
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool_->queryPool(), query);
+#endif
+}
+
+void Vulkan::collectTimestamps() {
+#ifdef ENABLE_PROFILER
+    // only called once the fence of the frame that wrote them has signaled
+    if (!timestampsPending_) {
+        return ;
+    }
+    timestampsPending_ = false;
+
+    std::array<uint64_t, TimestampQueryCount> ticks{};
+    auto result = vkGetQueryPoolResults(device_, timestampQueryPool_->queryPool(), 0, TimestampQueryCount, sizeof(ticks), ticks.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) {
+        return ;
+    }
+
+    // the GPU clock has no fixed relation to ours, so anchor the start of the frame at its submit time
+    auto toNanoseconds = [&](uint32_t query) {
+        auto elapsed = (ticks[query] - ticks[FrameBegin]) & timestampMask_;
+        return submitTime_ + static_cast<uint64_t>(static_cast<double>(elapsed) * timestampPeriod_);
+    };
+    auto& profiler = Profiler::instance();
+    profiler.addGpuEvent("gpu frame", toNanoseconds(FrameBegin), toNanoseconds(CanvasEnd));
+    profiler.addGpuEvent("uploads", toNanoseconds(FrameBegin), toNanoseconds(UploadsEnd));
+    profiler.addGpuEvent("lines", toNanoseconds(UploadsEnd), toNanoseconds(LinesEnd));
+    profiler.addGpuEvent("text", toNanoseconds(LinesEnd), toNanoseconds(TextEnd));
+    profiler.addGpuEvent("canvas", toNanoseconds(TextEnd), toNanoseconds(CanvasEnd));
+#endif
+}
+
+// Runs with nothing in flight: draw() calls it right after the fence wait, and the copies are waited on here.
+void Vulkan::defragment() {
+    // a relocated copy would miss the queued uploads, the next frame records them
+    if (!bufferUploads_.empty()) {
+        return ;
+    }
+    if (!allocator_->defragmenting() && !allocator_->beginDefragmentation()) {
+        return ;
+    }
+    PROFILE_SCOPE("defragment");
+
+    // old resources stay alive until the copies out of them have finished
+    std::vector<std::shared_ptr<void>> retired;
+    VkDeviceSize moved = 0;
+
+    auto commandBuffer = beginSingleTimeCommands();
+        auto relocate = [&](auto& resource) {
+            if (!resource || moved >= defragmentBudget_) {
+                return ;
+            }
+            auto replacement = relocated(*resource, commandBuffer);
+            if (!replacement) {
+                return ;
+            }
+            moved += resource->allocation().size_;
+            retired.push_back(std::move(resource));
+            resource = std::move(replacement);
+        };
+
+        relocate(canvasVertexBuffer_);
+        relocate(canvasIndexBuffer_);
+        relocate(lineVertexBuffers_);
+        relocate(lineIndexBuffers_);
+        relocate(fontVertexBuffer_);
+        relocate(uniformBuffers_);
+        relocate(canvasUniformBuffer_);
+        relocate(canvasTileTable_);
+        relocate(canvasImage_);
+        relocate(glyphAtlasImage_);
+    endSingleTimeCommands(commandBuffer, graphicsQueue_);
+
+    if (moved != 0) {
+        writeBrushDescriptorSet();
+        writeTextDescriptorSet();
+        writeCanvasDescriptorSet();
+    }
+    // the copies are done, this releases their old ranges in the evacuated block
+    retired.clear();
+    defragmentMoved_ += moved;
+
+    // done when the block is empty, or when what is left in it isn't ours to move
+    if (moved == 0 || allocator_->evacuatingUsed() == 0) {
+        auto reclaimed = allocator_->endDefragmentation();
+        reclaimedBytes_ += reclaimed;
+        if (defragmentMoved_ != 0 || reclaimed != 0) {
+            std::cout << std::format("defragment: moved {} bytes, reclaimed {} bytes", defragmentMoved_, reclaimed) << std::endl;
+        }
+        defragmentMoved_ = 0;
+        // back off before looking at the pools again
+        idleFrames_ = 0;
+    }
+}
+
+// a copy of buffer outside the block being evacuated, or nullptr when it isn't in it or can't leave
+std::unique_ptr<Buffer> Vulkan::relocated(const Buffer& buffer, VkCommandBuffer commandBuffer) {
+    if (!allocator_->evacuating(buffer.allocation())) {
+        return nullptr;
+    }
+
+    auto families = queueFamilies_.sets();
+    auto moved = std::make_unique<Buffer>(physicalDevice_, device_, allocator_.get());
+    moved->size_ = buffer.size_;
+    moved->usage_ = buffer.usage_;
+    moved->sharingMode_ = buffer.sharingMode_;
+    moved->queueFamilyIndexCount_ = static_cast<uint32_t>(families.size());
+    moved->pQueueFamilyIndices_ = families.data();
+    moved->memoryProperties_ = buffer.memoryProperties_;
+    moved->memoryUsage_ = buffer.memoryUsage_;
+    moved->memoryTag_ = buffer.memoryTag_;
+    moved->init();
+    // no room elsewhere after all
+    if (allocator_->evacuating(moved->allocation())) {
+        return nullptr;
+    }
+
+    // both sides of a host-visible buffer are persistently mapped, no need for the GPU
+    if (buffer.allocation().mapped_ && moved->allocation().mapped_) {
+        memcpy(moved->allocation().mapped_, buffer.allocation().mapped_, buffer.size_);
+    } else {
+        VkBufferCopy copyRegion{};
+        copyRegion.size = buffer.size_;
+        vkCmdCopyBuffer(commandBuffer, buffer.buffer(), moved->buffer(), 1, &copyRegion);
+    }
+
+    return moved;
+}
+
+// every image we relocate is a sampled texture resting in SHADER_READ_ONLY_OPTIMAL
+std::unique_ptr<Image> Vulkan::relocated(const Image& image, VkCommandBuffer commandBuffer) {
+    if (!allocator_->evacuating(image.allocation())) {
+        return nullptr;
+    }
+
+    auto families = queueFamilies_.sets();
+    auto moved = std::make_unique<Image>(physicalDevice_, device_, allocator_.get());
+    moved->imageType_ = image.imageType_;
+    moved->flags_ = image.flags_;
+    moved->format_ = image.format_;
+    moved->extent_ = image.extent_;
+    moved->mipLevles_ = image.mipLevles_;
+    moved->arrayLayers_ = image.arrayLayers_;
+    moved->samples_ = image.samples_;
+    moved->tiling_ = image.tiling_;
+    moved->usage_ = image.usage_;
+    moved->sharingMode_ = image.sharingMode_;
+    moved->queueFamilyIndexCount_ = static_cast<uint32_t>(families.size());
+    moved->pQueueFamilyIndices_ = families.data();
+    moved->memoryProperties_ = image.memoryProperties_;
+    moved->preferredMemoryProperties_ = image.preferredMemoryProperties_;
+    moved->memoryUsage_ = image.memoryUsage_;
+    moved->memoryTag_ = image.memoryTag_;
+    moved->viewType_ = image.viewType_;
+    moved->subresourcesRange_ = image.subresourcesRange_;
+    moved->init();
+    if (allocator_->evacuating(moved->allocation())) {
+        return nullptr;
+    }
+
+    auto range = image.subresourcesRange_;
+    Tools::setImageLayout(commandBuffer, image.image(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, range, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    Tools::setImageLayout(commandBuffer, moved->image(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    std::vector<VkImageCopy> regions(image.mipLevles_);
+    for (uint32_t level = 0; level < image.mipLevles_; level++) {
+        regions[level].srcSubresource = {range.aspectMask, level, 0, image.arrayLayers_};
+        regions[level].dstSubresource = regions[level].srcSubresource;
+        regions[level].extent = {std::max(1u, image.extent_.width >> level), std::max(1u, image.extent_.height >> level), std::max(1u, image.extent_.depth >> level)};
+    }
+    vkCmdCopyImage(commandBuffer, image.image(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, moved->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+    Tools::setImageLayout(commandBuffer, moved->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+    return moved;
 }
 
 void Vulkan::recordCommadBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+    PROFILE_SCOPE("recordCommadBuffer");
+
     VkCommandBufferBeginInfo commandBufferBeginInfo{};
     commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
@@ -1297,15 +1605,29 @@ void Vulkan::recordCommadBuffer(VkCommandBuffer commandBuffer, uint32_t imageInd
         throw std::runtime_error("failed to begin command buffer!");
     }
 
+    beginTimestamps(commandBuffer);
+    recordBufferUploads(commandBuffer);
+    recordGlyphUploads(commandBuffer);
+    recordTextureLoad(commandBuffer);
+    recordTileUploads(commandBuffer);
+    writeTimestamp(commandBuffer, UploadsEnd);
+
     VkRenderPassBeginInfo renderPassBeginInfo{};
     renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassBeginInfo.renderPass = renderPass_->renderPass();
     renderPassBeginInfo.framebuffer = frameBuffers_[imageIndex]->frameBuffer();
     renderPassBeginInfo.renderArea.extent = swapChain_->extent();
-    std::vector<VkClearValue> clearValues(3);
+    // one clear value per attachment, in the order createRenderPass adds them
+    std::vector<VkClearValue> clearValues(multisampled() ? 2 : 1);
     clearValues[0].color = {0.0f, 0.0f, 0.0f, 0.0f};
-    clearValues[1].color = {0.0f, 0.0f, 0.0f, 0.0f};
-    clearValues[2].depthStencil = {1.0f, 0};
+    if (multisampled()) {
+        clearValues[1].color = {0.0f, 0.0f, 0.0f, 0.0f};
+    }
+    if (config_.depthAttachment_) {
+        VkClearValue depthClear{};
+        depthClear.depthStencil = {1.0f, 0};
+        clearValues.push_back(depthClear);
+    }
     renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassBeginInfo.pClearValues = clearValues.data();
 
@@ -1337,9 +1659,10 @@ void Vulkan::recordCommadBuffer(VkCommandBuffer commandBuffer, uint32_t imageInd
             
             vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(lineIndices_.size()), 1, 0, 0, 0);
         }
+        writeTimestamp(commandBuffer, LinesEnd);
 
         // chars
-        if (text_.size()) {
+        if (text_.size() && textLayout_.size()) {
             vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, fontPipeline_->pipeline());
 
             std::vector<VkDescriptorSet> descriptorSets{fontDescriptorSet_};
@@ -1347,10 +1670,11 @@ void Vulkan::recordCommadBuffer(VkCommandBuffer commandBuffer, uint32_t imageInd
 
             std::vector<VkBuffer> vertexBuffer = {fontVertexBuffer_->buffer()};
             vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffer.data(), offsets);
-            vkCmdBindIndexBuffer(commandBuffer, fontIndexBuffer_->buffer(), 0, VK_INDEX_TYPE_UINT32);
-            
-            vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(fontIndices_.size()), 1, 0, 0, 0);
+
+            // Font.vert builds each glyph's quad from gl_VertexIndex
+            vkCmdDraw(commandBuffer, 6, textLayout_.size(), 0, 0);
         }
+        writeTimestamp(commandBuffer, TextEnd);
 
         // Canvas
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, canvasPipeline_->pipeline());
@@ -1363,31 +1687,85 @@ void Vulkan::recordCommadBuffer(VkCommandBuffer commandBuffer, uint32_t imageInd
 
     vkCmdEndRenderPass(commandBuffer);
 
+    writeTimestamp(commandBuffer, CanvasEnd);
+
     if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
         throw std::runtime_error("failed to end command buffer!");
     }
 }
 
 void Vulkan::draw() {
+    PROFILE_SCOPE("draw");
+
     timer_.tick();
-    camera_->setDeltaTime(timer_.deltaMilliseconds());
+    camera_->setDeltaTime(static_cast<float>(timer_.deltaSeconds()));
+    // the first delta covers initialization, not a frame
+    if (frameIndex_ != 0) {
+        frameTimes_.record(timer_.deltaNanoseconds());
+    }
 
+    {
+        PROFILE_SCOPE("wait fence");
+        vkWaitForFences(device_, 1, inFlightFences_->fencePtr(), VK_TRUE, UINT64_MAX);
+    }
+    completedFrame_ = frameIndex_;
+    if (!inFlightInputTimes_.empty() && inFlightInputFrame_ < completedFrame_) {
+        auto now = Timer::nowNanoseconds();
+        for (auto time : inFlightInputTimes_) {
+            inputLatency_.record(now - time);
+        }
+        inFlightInputTimes_.clear();
+    }
+    collectTimestamps();
+    deletionQueue_.collect(completedFrame_);
 
-    uint32_t imageIndex = 0;
-    vkAcquireNextImageKHR(device_, swapChain_->swapChain(), UINT64_MAX, imageAvaiableSemaphores_->semaphore(), VK_NULL_HANDLE, &imageIndex);
+    idleFrames_ = (ok_ || LeftButton_ || inputText_) ? 0 : idleFrames_ + 1;
+    if (idleFrames_ >= defragmentIdleFrames_) {
+        defragment();
+    }
 
-    vkResetFences(device_, 1, inFlightFences_->fencePtr());
+    uint32_t imageIndex = 0;
+    auto result = VK_SUCCESS;
+    if (config_.headless_) {
+        imageIndex = static_cast<uint32_t>(frameIndex_ % swapChain_->size());
+    } else {
+        PROFILE_SCOPE("acquire");
+        result = vkAcquireNextImageKHR(device_, swapChain_->swapChain(), UINT64_MAX, imageAvaiableSemaphores_->semaphore(), VK_NULL_HANDLE, &imageIndex);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            recreateSwapChain();
+            return ;
+        } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            throw std::runtime_error("failed to acquire swap chain image!");
+        }
+    }
 
     vkResetCommandBuffer(commandBuffers_->commandBuffer(), 0);
 
+    // the image is ours now, so any input polled from here on lands in this frame
+    if (config_.framePacing_ == Config::FramePacing::JustInTime && !config_.headless_) {
+        glfwPollEvents();
+    }
+
+    // after defragment, which must never see the canvas before its transition is recorded
+    pollTextureLoad();
+    updateCanvasTiles();
     updateDrawAssets();
 
     recordCommadBuffer(commandBuffers_->commandBuffer(), imageIndex);
 
-    std::vector<VkSemaphore> waits = {imageAvaiableSemaphores_->semaphore()};
-    std::vector<VkPipelineStageFlags> waitStages = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+    std::vector<VkSemaphore> waits, signals;
+    std::vector<VkPipelineStageFlags> waitStages;
     std::vector<VkCommandBuffer> commandBuffers = {commandBuffers_->commandBuffer()};
-    std::vector<VkSemaphore> signals = {renderFinishSemaphores_->semaphore()};
+    if (!config_.headless_) {
+        waits.push_back(imageAvaiableSemaphores_->semaphore());
+        waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        signals.push_back(renderFinishSemaphores_->semaphore());
+    }
+    if (textureUploaded_) {
+        waits.push_back(textureUploadSemaphore_->semaphore());
+        waitStages.push_back(VK_PIPELINE_STAGE_TRANSFER_BIT);
+        textureUploaded_ = false;
+    }
 
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -1399,9 +1777,21 @@ void Vulkan::draw() {
     submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signals.size());
     submitInfo.pSignalSemaphores = signals.data();
 
+#ifdef ENABLE_PROFILER
+    submitTime_ = Timer::nowNanoseconds();
+    timestampsPending_ = timestampQueryPool_ != nullptr;
+#endif
+    // reset only now: anything run while recording, like input polled just in time, may wait on it
+    vkResetFences(device_, 1, inFlightFences_->fencePtr());
     if (vkQueueSubmit(graphicsQueue_, 1, &submitInfo, inFlightFences_->fence()) != VK_SUCCESS) {
         throw std::runtime_error("failed to queue submit!");
     }
+    frameIndex_++;
+
+    if (config_.headless_) {
+        renderedImage_ = imageIndex;
+        return ;
+    }
 
     std::vector<VkSwapchainKHR> swapChains = {swapChain_->swapChain()};
 
@@ -1413,160 +1803,216 @@ void Vulkan::draw() {
     presentInfo.pWaitSemaphores = signals.data();
     presentInfo.pImageIndices = &imageIndex;
 
-    auto result = vkQueuePresentKHR(presentQueue_, &presentInfo);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+    {
+        PROFILE_SCOPE("present");
+        result = vkQueuePresentKHR(presentQueue_, &presentInfo);
+    }
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || resized_) {
+        resized_ = false;
         recreateSwapChain();
-        return ;
-    } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+    } else if (result != VK_SUCCESS) {
         throw std::runtime_error("faield to present!");
     }
-
-    vkWaitForFences(device_, 1, inFlightFences_->fencePtr(), VK_TRUE, UINT64_MAX);
 }
 
 void Vulkan::loadAssets() {
+    if (!config_.assetPackPath_.empty()) {
+        try {
+            assetPack_ = std::make_unique<AssetPack>(config_.assetPackPath_);
+        } catch (const std::runtime_error& e) {
+            std::cout << e.what() << ", loading assets from source" << std::endl;
+        }
+    }
+
     loadTextures();
     loadChars();
 }
 
+ShaderModule Vulkan::loadShader(const std::string& name) {
+    if (assetPack_) {
+        if (auto code = assetPack_->find("shaders/" + name, "../shaders/spv/" + name)) {
+            return ShaderModule(device_, reinterpret_cast<const uint32_t*>(code->data_), code->size_);
+        }
+    }
+    return ShaderModule(device_, "../shaders/spv/" + name);
+}
+
 void Vulkan::loadTextures() {
-    int texWidth, texHeight, texChannels;
-    auto pixel = stbi_load(canvasTexturePath_.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    if (!pixel) {
+    PROFILE_SCOPE("loadTextures");
+
+    canvasTiles_ = decodeCanvasTiles(config_.canvasTexturePath_, assetPack_.get(), config_.canvasTileSize_, canvasTileSlots(), canvasMaxExtent());
+    if (!canvasTiles_) {
         throw std::runtime_error("failed to load canvas texture");
     }
+    canvasImage_ = createCanvasImage(canvasTiles_->slots());
+    canvasTileTable_ = createTileTable(*canvasTiles_);
 
-    VkDeviceSize size = texWidth * texHeight * 4;
-
-    canvasImage_ = std::make_unique<Image>(physicalDevice_, device_);
-    canvasImage_->imageType_ = VK_IMAGE_TYPE_2D;
-    canvasImage_->arrayLayers_ = 1;
-    canvasImage_->mipLevles_ = 1;
-    canvasImage_->format_ = VK_FORMAT_R8G8B8A8_SRGB;
-    canvasImage_->extent_ = {static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1};
-    canvasImage_->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
-    canvasImage_->pQueueFamilyIndices_ = queueFamilies_.sets().data();
-    canvasImage_->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
-    canvasImage_->tiling_ = VK_IMAGE_TILING_OPTIMAL;
-    canvasImage_->usage_ = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-    canvasImage_->memoryProperties_ = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-    canvasImage_->viewType_ = VK_IMAGE_VIEW_TYPE_2D;
-    canvasImage_->samples_ = VK_SAMPLE_COUNT_1_BIT;
-    canvasImage_->subresourcesRange_ = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
-    canvasImage_->init();
-    
-    std::unique_ptr<Buffer> staginBuffer = std::make_unique<Buffer>(physicalDevice_, device_);
-    staginBuffer->size_ = size;
-    staginBuffer->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
-    staginBuffer->pQueueFamilyIndices_ = queueFamilies_.sets().data();
-    staginBuffer->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
-    staginBuffer->usage_ = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    staginBuffer->memoryProperties_ = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-    staginBuffer->init();
-    
-    auto data = staginBuffer->map(size);
-    memcpy(data, pixel, size);
-    staginBuffer->unMap();
-
-    VkImageSubresourceRange range{1, 0, 1, 0, 1};
-    VkBufferImageCopy region{};
-    region.imageOffset = {0, 0, 0};
-    region.imageExtent = {static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1};
-    region.imageSubresource = {1, 0, 0, 1};
+    std::vector<VkBufferImageCopy> regions;
+    auto staging = stageTiles(showCanvas(*canvasTiles_), regions);
+    writeTileTable(*canvasTileTable_, *canvasTiles_);
 
+    VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, canvasTiles_->slots()};
     auto cmdBuffer = beginSingleTimeCommands();
         Tools::setImageLayout(cmdBuffer, canvasImage_->image(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
 
-        vkCmdCopyBufferToImage(cmdBuffer, staginBuffer->buffer(), canvasImage_->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        vkCmdCopyBufferToImage(cmdBuffer, staging->buffer(), canvasImage_->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
 
         Tools::setImageLayout(cmdBuffer, canvasImage_->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
         
-    endSingleTimeCommands(cmdBuffer, transferQueue_);
+    endSingleTimeCommands(cmdBuffer, graphicsQueue_);
 }
 
 void Vulkan::loadChars() {
-    font_ = std::make_unique<Font>(fontPath_.c_str(), 32);
-
-    for (uint32_t i = 0; i < 128; i++) {
-        char c = static_cast<char>(i);
-        font_->loadChar(c);
-        auto& currentChar = dictionary_[c];
-
-        auto pixel = font_->bitmap().buffer;
-        auto texWidth = font_->bitmap().width;
-        auto texHeight = font_->bitmap().rows;
-        auto offsetX = font_->glyph()->bitmap_left;
-        auto offsetY = font_->glyph()->bitmap_top;
-        auto advance = font_->glyph()->advance.x / 64;
-        VkDeviceSize size = texWidth * texHeight * 1;
-
-        if (pixel == nullptr) {
-            texWidth = 15;
-            texHeight = 18;
-            offsetX = 2;
-            offsetY = 18;
-            advance = 19;
-            size = texWidth * texHeight * 1;
+    PROFILE_SCOPE("loadChars");
+
+    glyphCache_ = &fontManager_.glyphs(config_.fontPath_, config_.fontBaseSize_, config_.fontSpread_, config_.glyphAtlasSize_);
+    if (!assetPack_ || !glyphCache_->restore(*assetPack_)) {
+        // ASCII up front, everything else the first time it is typed
+        std::vector<uint32_t> codepoints(128);
+        for (uint32_t i = 0; i < codepoints.size(); i++) {
+            codepoints[i] = i;
         }
+        PROFILE_SCOPE("renderSdf");
+        glyphCache_->preload(codepoints);
+    }
+    auto& atlas = glyphCache_->atlas();
+    // the whole atlas goes up below
+    atlas.takeDirty();
+
+    auto families = queueFamilies_.sets();
+    glyphAtlasImage_ = std::make_unique<Image>(physicalDevice_, device_, allocator_.get());
+    glyphAtlasImage_->imageType_ = VK_IMAGE_TYPE_2D;
+    glyphAtlasImage_->arrayLayers_ = 1;
+    glyphAtlasImage_->mipLevles_ = 1;
+    glyphAtlasImage_->format_ = VK_FORMAT_R8_UNORM;
+    glyphAtlasImage_->extent_ = {atlas.width(), atlas.height(), 1};
+    glyphAtlasImage_->queueFamilyIndexCount_ = static_cast<uint32_t>(families.size());
+    glyphAtlasImage_->pQueueFamilyIndices_ = families.data();
+    glyphAtlasImage_->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+    glyphAtlasImage_->tiling_ = VK_IMAGE_TILING_OPTIMAL;
+    glyphAtlasImage_->usage_ = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    glyphAtlasImage_->memoryProperties_ = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    glyphAtlasImage_->memoryUsage_ = Tools::MemoryUsage::GpuOnly;
+    glyphAtlasImage_->memoryTag_ = Tools::MemoryTag::Glyphs;
+    glyphAtlasImage_->viewType_ = VK_IMAGE_VIEW_TYPE_2D;
+    glyphAtlasImage_->samples_ = VK_SAMPLE_COUNT_1_BIT;
+    glyphAtlasImage_->subresourcesRange_ = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    glyphAtlasImage_->init();
+
+    VkDeviceSize size = atlas.pixels().size();
+    Buffer staginBuffer(physicalDevice_, device_, allocator_.get());
+    staginBuffer.size_ = size;
+    staginBuffer.queueFamilyIndexCount_ = static_cast<uint32_t>(families.size());
+    staginBuffer.pQueueFamilyIndices_ = families.data();
+    staginBuffer.sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+    staginBuffer.usage_ = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    staginBuffer.memoryProperties_ = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    staginBuffer.memoryUsage_ = Tools::MemoryUsage::Upload;
+    staginBuffer.memoryTag_ = Tools::MemoryTag::Staging;
+    staginBuffer.init();
+
+    memcpy(staginBuffer.map(size), atlas.pixels().data(), size);
+    staginBuffer.unMap();
+
+    VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    VkBufferImageCopy region{};
+    region.imageExtent = {atlas.width(), atlas.height(), 1};
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+
+    auto cmdBuffer = beginSingleTimeCommands();
+        Tools::setImageLayout(cmdBuffer, glyphAtlasImage_->image(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+        vkCmdCopyBufferToImage(cmdBuffer, staginBuffer.buffer(), glyphAtlasImage_->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        Tools::setImageLayout(cmdBuffer, glyphAtlasImage_->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    endSingleTimeCommands(cmdBuffer, graphicsQueue_);
+}
+
+void Vulkan::stageGlyphUploads() {
+    auto& atlas = glyphCache_->atlas();
+    auto dirty = atlas.takeDirty();
+    if (dirty.empty()) {
+        return ;
+    }
+
+    // a batch not recorded yet is carried over in front of the new regions, which keep their offsets
+    VkDeviceSize carried = glyphStaging_ ? glyphStaging_->size_ : 0;
+    VkDeviceSize size = carried;
+    for (const auto& rect : dirty) {
+        size += static_cast<VkDeviceSize>(rect.width_) * rect.height_;
+    }
 
-        currentChar.char_ = c;
-        currentChar.offsetX_ = offsetX;
-        currentChar.offsetY_ = offsetY;
-        currentChar.width_ = texWidth;
-        currentChar.height_ = texHeight;
-        currentChar.advance_ = advance;
-        currentChar.color_ = glm::vec3(0.0f, 0.0f, 0.0f);
-        currentChar.index_ = i;
-
-        auto& image = currentChar.image_;        
-        image = std::make_unique<Image>(physicalDevice_, device_);
-        image->imageType_ = VK_IMAGE_TYPE_2D;
-        image->arrayLayers_ = 1;
-        image->mipLevles_ = 1;
-        image->format_ = VK_FORMAT_R8_UNORM;
-        image->extent_ = {texWidth, texHeight, 1};
-        image->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
-        image->pQueueFamilyIndices_ = queueFamilies_.sets().data();
-        image->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
-        image->tiling_ = VK_IMAGE_TILING_OPTIMAL;
-        image->usage_ = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-        image->memoryProperties_ = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-        image->viewType_ = VK_IMAGE_VIEW_TYPE_2D;
-        image->samples_ = VK_SAMPLE_COUNT_1_BIT;
-        image->subresourcesRange_ = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
-        image->init();
-
-        Buffer staginBuffer(physicalDevice_, device_);
-        staginBuffer.size_ = size;
-        staginBuffer.queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
-        staginBuffer.pQueueFamilyIndices_ = queueFamilies_.sets().data();
-        staginBuffer.sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
-        staginBuffer.usage_ = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        staginBuffer.memoryProperties_ = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-        staginBuffer.init();
-
-        auto data = staginBuffer.map(size);
-        if (pixel == nullptr) {
-            memset(data, 0, size);
-        } else {
-            memcpy(data, pixel, size);
+    auto staging = std::make_unique<Buffer>(physicalDevice_, device_, allocator_.get());
+    staging->size_ = size;
+    staging->usage_ = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    staging->sharingMode_ = VK_SHARING_MODE_EXCLUSIVE;
+    staging->memoryProperties_ = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    staging->memoryUsage_ = Tools::MemoryUsage::Upload;
+    staging->memoryTag_ = Tools::MemoryTag::Staging;
+    staging->init();
+
+    auto data = static_cast<uint8_t*>(staging->map(size));
+    if (glyphStaging_) {
+        memcpy(data, glyphStaging_->map(carried), carried);
+        glyphStaging_->unMap();
+    }
+    glyphStaging_ = std::move(staging);
+    VkDeviceSize offset = carried;
+    for (const auto& rect : dirty) {
+        for (uint32_t row = 0; row < rect.height_; row++) {
+            memcpy(data + offset + static_cast<VkDeviceSize>(row) * rect.width_, &atlas.pixels()[static_cast<size_t>(rect.y_ + row) * atlas.width() + rect.x_], rect.width_);
         }
-        staginBuffer.unMap();
 
-        VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
         VkBufferImageCopy region{};
-        region.imageExtent = {texWidth, texHeight, 1};
-        region.imageSubresource = {1, 0, 0, 1};
+        region.bufferOffset = offset;
+        region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        region.imageOffset = {static_cast<int32_t>(rect.x_), static_cast<int32_t>(rect.y_), 0};
+        region.imageExtent = {rect.width_, rect.height_, 1};
+        glyphRegions_.push_back(region);
+
+        offset += static_cast<VkDeviceSize>(rect.width_) * rect.height_;
+    }
+    glyphStaging_->unMap();
+}
+
+void Vulkan::recordGlyphUploads(VkCommandBuffer commandBuffer) {
+    if (!glyphStaging_) {
+        return ;
+    }
+
+    VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    Tools::setImageLayout(commandBuffer, glyphAtlasImage_->image(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    vkCmdCopyBufferToImage(commandBuffer, glyphStaging_->buffer(), glyphAtlasImage_->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(glyphRegions_.size()), glyphRegions_.data());
+    Tools::setImageLayout(commandBuffer, glyphAtlasImage_->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+    retire(glyphStaging_);
+    glyphRegions_.clear();
+}
 
-        auto cmdBuffer = beginSingleTimeCommands();
-            Tools::setImageLayout(cmdBuffer, image->image(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-            vkCmdCopyBufferToImage(cmdBuffer, staginBuffer.buffer(), image->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-            Tools::setImageLayout(cmdBuffer, image->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
-        endSingleTimeCommands(cmdBuffer, transferQueue_);
+void Vulkan::reserveTextGlyphs(uint32_t glyphs) {
+    // double so a growing line reallocates a logarithmic number of times
+    fontGlyphCapacity_ = std::max({glyphs, fontGlyphCapacity_ * 2, 64u});
+
+    VkDeviceSize size = sizeof(Font::Glyph) * fontGlyphCapacity_;
+    retire(fontVertexBuffer_);
+    auto families = queueFamilies_.sets();
+    fontVertexBuffer_ = std::make_unique<Buffer>(physicalDevice_, device_, allocator_.get());
+    fontVertexBuffer_->size_ = size;
+    fontVertexBuffer_->usage_ = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    fontVertexBuffer_->queueFamilyIndexCount_ = static_cast<uint32_t>(families.size());
+    fontVertexBuffer_->pQueueFamilyIndices_ = families.data();
+    fontVertexBuffer_->sharingMode_ = queueFamilies_.sharingMode();
+    fontVertexBuffer_->memoryUsage_ = Tools::MemoryUsage::Dynamic;
+    fontVertexBuffer_->memoryTag_ = Tools::MemoryTag::Vertices;
+    fontVertexBuffer_->init();
+
+    // glyphs laid out before the new buffer existed
+    if (textLayout_.size()) {
+        upload(*fontVertexBuffer_, textLayout_.glyphs().data(), sizeof(Font::Glyph) * textLayout_.size());
     }
 }
 
 void Vulkan::updateDrawAssets() {
+    PROFILE_SCOPE("updateDrawAssets");
+
     UniformBufferObject ubo{};
     ubo.proj_ = glm::ortho(-static_cast<float>(swapChain_->width()) / 2.0f, static_cast<float>(swapChain_->width()) / 2.0f, -static_cast<float>(swapChain_->height()) / 2.0f, static_cast<float>(swapChain_->height()) / 2.0f);
     auto data = uniformBuffers_->map(sizeof(ubo));    
@@ -1583,121 +2029,137 @@ void Vulkan::updateDrawAssets() {
             changePoint();
             prevCursorHandled_ = true;
 
-            VkDeviceSize size = sizeof(Line::Point) * lineVertices_.size();
-
-            Buffer staginBuffer(physicalDevice_, device_);
-            staginBuffer.size_ = size;
-            staginBuffer.usage_ = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-            staginBuffer.sharingMode_ = VK_SHARING_MODE_EXCLUSIVE;
-            staginBuffer.queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
-            staginBuffer.pQueueFamilyIndices_ = queueFamilies_.sets().data();
-            staginBuffer.memoryProperties_ = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-            staginBuffer.init();
-
-            auto data = staginBuffer.map(size);
-            memcpy(data, lineVertices_.data(), size);
-            staginBuffer.unMap();
+            // this frame carries the ink for every sample that arrived since the last one
+            inFlightInputTimes_.insert(inFlightInputTimes_.end(), pendingInputTimes_.begin(), pendingInputTimes_.end());
+            inFlightInputFrame_ = frameIndex_;
+            pendingInputTimes_.clear();
+        }
 
-            copyBuffer(staginBuffer.buffer(), lineVertexBuffers_->buffer(), size);
+        // only the points strokes or committed text touched
+        if (lineDirtyBegin_ < lineDirtyEnd_) {
+            VkDeviceSize offset = sizeof(Line::Point) * lineDirtyBegin_;
+            VkDeviceSize size = sizeof(Line::Point) * (lineDirtyEnd_ - lineDirtyBegin_);
+            upload(*lineVertexBuffers_, lineVertices_.data() + lineDirtyBegin_, size, offset);
         }
+        lineDirtyBegin_ = UINT32_MAX;
+        lineDirtyEnd_ = 0;
     }
 
     {   
         if (inputText_ && text_.size()) {
-            auto t = font_->generateText(-static_cast<float>(swapChain_->width()) / 2.0f, -static_cast<float>(swapChain_->height()) / 2.0f, text_, dictionary_);
-            fontVertices_ = t.first;
-            fontIndices_ = t.second;
-            
-            // font vertices
-            VkDeviceSize size = sizeof(fontVertices_[0]) * fontVertices_.size();
-
-            fontVertexBuffer_.reset(nullptr);
-            fontVertexBuffer_ = std::make_unique<Buffer>(physicalDevice_, device_);
-            fontVertexBuffer_->size_ = size;
-            fontVertexBuffer_->usage_ = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-            fontVertexBuffer_->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
-            fontVertexBuffer_->pQueueFamilyIndices_ = queueFamilies_.sets().data();
-            fontVertexBuffer_->sharingMode_ = queueFamilies_.sharingMode();
-            fontVertexBuffer_->memoryProperties_ = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-            fontVertexBuffer_->init();
-
-            auto staginBuffer = std::make_unique<Buffer>(physicalDevice_, device_);
-            staginBuffer->size_ = size;
-            staginBuffer->usage_ = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-            staginBuffer->sharingMode_ = VK_SHARING_MODE_EXCLUSIVE;
-            staginBuffer->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
-            staginBuffer->pQueueFamilyIndices_ = queueFamilies_.sets().data();
-            staginBuffer->memoryProperties_ = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-            staginBuffer->init();
-
-            auto data = staginBuffer->map(size);
-            memcpy(data, fontVertices_.data(), size);
-            staginBuffer->unMap();
-
-            copyBuffer(staginBuffer->buffer(), fontVertexBuffer_->buffer(), size);
-
-            // font index
-            size = sizeof(fontIndices_[0]) * fontIndices_.size();
-
-            fontIndexBuffer_.reset(nullptr);
-            fontIndexBuffer_ = std::make_unique<Buffer>(physicalDevice_, device_);
-            fontIndexBuffer_->size_ = size;
-            fontIndexBuffer_->usage_ = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-            fontIndexBuffer_->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
-            fontIndexBuffer_->pQueueFamilyIndices_ = queueFamilies_.sets().data();
-            fontIndexBuffer_->sharingMode_ = queueFamilies_.sharingMode();
-            fontIndexBuffer_->memoryProperties_ = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-            fontIndexBuffer_->init();
-
-            staginBuffer = std::make_unique<Buffer>(physicalDevice_, device_);
-            staginBuffer->size_ = size;
-            staginBuffer->usage_ = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-            staginBuffer->sharingMode_ = VK_SHARING_MODE_EXCLUSIVE;
-            staginBuffer->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
-            staginBuffer->pQueueFamilyIndices_ = queueFamilies_.sets().data();
-            staginBuffer->memoryProperties_ = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-            staginBuffer->init();
-
-            data = staginBuffer->map(size);
-            memcpy(data, fontIndices_.data(), size);
-            staginBuffer->unMap();
-
-            copyBuffer(staginBuffer->buffer(), fontIndexBuffer_->buffer(), size);
+            glyphCache_->beginFrame(frameIndex_, completedFrame_);
+            // any eviction since the last layout, from stamped text or this one, may have emptied a
+            // shelf unchanged quads point at; with a single frame in flight no earlier frame still
+            // samples it, and a full pass pins everything laid out again
+            if (glyphCache_->evictions() != lastEvictions_) {
+                textLayout_.invalidate();
+                laidOutText_.clear();
+            }
+            if (text_ != laidOutText_) {
+                auto text = Tools::decodeUtf8(text_);
+                auto x = -static_cast<float>(swapChain_->width()) / 2.0f, y = -static_cast<float>(swapChain_->height()) / 2.0f;
+                auto glyph = [this](char32_t c) {
+                    return glyphCache_->glyph(c);
+                };
+                auto evictions = glyphCache_->evictions();
+                textLayout_.update(x, y, fontSize_ / config_.fontBaseSize_, text, glyph);
+                if (glyphCache_->evictions() != evictions) {
+                    textLayout_.invalidate();
+                    textLayout_.update(x, y, fontSize_ / config_.fontBaseSize_, text, glyph);
+                }
+                lastEvictions_ = glyphCache_->evictions();
+                laidOutText_ = text_;
+            }
+
+            if (textLayout_.size() > fontGlyphCapacity_) {
+                reserveTextGlyphs(textLayout_.size());
+            }
+            auto dirty = textLayout_.takeDirty();
+            if (dirty.first < dirty.second) {
+                upload(*fontVertexBuffer_, textLayout_.glyphs().data() + dirty.first, sizeof(Font::Glyph) * (dirty.second - dirty.first), sizeof(Font::Glyph) * dirty.first);
+            }
         }
+        // every glyph rasterized since the last frame, stamped text's included
+        stageGlyphUploads();
     }
 }   
 
 void Vulkan::recreateSwapChain() {
-    int width, height;
-    glfwGetWindowSize(windows_, &width, &height);
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(windows_, &width, &height);
     while (width == 0 || height == 0) {
-        glfwGetWindowSize(windows_, &width, &height);
-        glfwPollEvents();
+        // minimized, sleep until the window comes back instead of spinning
+        glfwWaitEvents();
+        glfwGetFramebufferSize(windows_, &width, &height);
     }
 
-    vkDeviceWaitIdle(device_);
-
-    swapChain_.reset(nullptr);
-
-    createSwapChain();
+    // the last submitted frame may still be using these, so hand them over instead of idling the device
+    auto oldSwapChain = swapChain_->swapChain();
+    // the old swapchain goes last: the framebuffers reference its image views
+    for (auto& frameBuffer : frameBuffers_) {
+        retire(frameBuffer);
+    }
+    frameBuffers_.clear();
+    retire(colorImage_);
+    retire(depthImage_);
+    retire(canvasVertexBuffer_);
+    retire(canvasIndexBuffer_);
+    retire(lineVertexBuffers_);
+    retire(lineIndexBuffers_);
+    retire(canvasUniformBuffer_);
+    retire(swapChain_);
+    // copies queued by a resize no frame was drawn after target the buffers retired above
+    bufferUploads_.clear();
+
+    createSwapChain(oldSwapChain);
     createColorResource();
     createDepthResource();
     createFrameBuffer();   
 
+    canvasViewChanged_ = true;
+    // the text line is anchored to the window's corner
+    laidOutText_.clear();
     createVertex();
+    // the ink starts over at the new size, committed text is stamped into it again
+    for (const auto& block : textBlocks_) {
+        stampText(block);
+    }
     createVertexBuffer();
     createIndexBuffer();
+    createCanvasUniformBuffer();
+}
 
-    {
-        auto data = canvasUniformBuffer_->map(sizeof(UniformBufferObject));
-        UniformBufferObject ubo{};
-        ubo.proj_ = glm::ortho(-static_cast<float>(swapChain_->width() / 2.0f), static_cast<float>(swapChain_->width() / 2.0f), -static_cast<float>(swapChain_->height() / 2.0), static_cast<float>(swapChain_->height() / 2.0f));
-        memcpy(data, &ubo, sizeof(UniformBufferObject));
-        canvasUniformBuffer_->unMap();
+
+VkPresentModeKHR Vulkan::preferredPresentMode() const {
+    switch (config_.presentPolicy_) {
+    case Config::PresentPolicy::Mailbox:
+        return VK_PRESENT_MODE_MAILBOX_KHR;
+    case Config::PresentPolicy::Immediate:
+        return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    case Config::PresentPolicy::FifoRelaxed:
+        return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    case Config::PresentPolicy::Fifo:
+        return VK_PRESENT_MODE_FIFO_KHR;
     }
+
+    return VK_PRESENT_MODE_FIFO_KHR;
 }
 
+uint64_t Vulkan::frameBudget() const {
+    if (config_.frameBudget_ != 0) {
+        return config_.frameBudget_;
+    }
 
+    int refreshRate = 60;
+    if (!config_.headless_) {
+        auto monitor = glfwGetWindowMonitor(windows_);
+        auto mode = glfwGetVideoMode(monitor ? monitor : glfwGetPrimaryMonitor());
+        if (mode && mode->refreshRate > 0) {
+            refreshRate = mode->refreshRate;
+        }
+    }
+    return 1'000'000'000ull / refreshRate;
+}
 
 bool Vulkan::checkValidationLayerSupport()  {
     uint32_t count = 0;
@@ -1731,8 +2193,8 @@ bool Vulkan::checkDeviceExtensionsSupport(VkPhysicalDevice physicalDevice)  {
 bool Vulkan::deviceSuitable(VkPhysicalDevice physicalDevice) {
     queueFamilies_ = Tools::QueueFamilyIndices::findQueueFamilies(physicalDevice, surface_);
     bool extensionSupport = checkDeviceExtensionsSupport(physicalDevice);
-    bool swapChainAdequate = false;
-    if (extensionSupport) {
+    bool swapChainAdequate = config_.headless_;
+    if (extensionSupport && !config_.headless_) {
         auto swapChainSupport = Tools::SwapChainSupportDetail::querySwapChainSupport(physicalDevice, surface_);
         swapChainAdequate = !swapChainSupport.formats_.empty() && !swapChainSupport.presentModes_.empty();
     }
@@ -1743,17 +2205,21 @@ bool Vulkan::deviceSuitable(VkPhysicalDevice physicalDevice) {
     return queueFamilies_.compeleted() && extensionSupport && swapChainAdequate && features.samplerAnisotropy;
 }
 
-VkSampleCountFlagBits Vulkan::getMaxUsableSampleCount()  {
+VkSampleCountFlagBits Vulkan::chooseSampleCount(VkSampleCountFlagBits requested) {
     VkPhysicalDeviceProperties properties;
     vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
 
-    auto count = properties.limits.framebufferColorSampleCounts & properties.limits.framebufferDepthSampleCounts;
-    if (count & VK_SAMPLE_COUNT_64_BIT) { return VK_SAMPLE_COUNT_64_BIT; }
-    if (count & VK_SAMPLE_COUNT_32_BIT) { return VK_SAMPLE_COUNT_32_BIT; }
-    if (count & VK_SAMPLE_COUNT_16_BIT) { return VK_SAMPLE_COUNT_16_BIT; }
-    if (count & VK_SAMPLE_COUNT_8_BIT) { return VK_SAMPLE_COUNT_8_BIT; }
-    if (count & VK_SAMPLE_COUNT_4_BIT) { return VK_SAMPLE_COUNT_4_BIT; }
-    if (count & VK_SAMPLE_COUNT_2_BIT) { return VK_SAMPLE_COUNT_2_BIT; }
+    auto count = properties.limits.framebufferColorSampleCounts;
+    if (config_.depthAttachment_) {
+        count &= properties.limits.framebufferDepthSampleCounts;
+    }
+
+    // highest supported count that does not exceed the request
+    for (uint32_t bit = requested; bit > VK_SAMPLE_COUNT_1_BIT; bit >>= 1) {
+        if (count & bit) {
+            return static_cast<VkSampleCountFlagBits>(bit);
+        }
+    }
 
     return VK_SAMPLE_COUNT_1_BIT;
 }
@@ -1771,7 +2237,7 @@ VkImageView Vulkan::createImageView(VkImage image, VkFormat format, VkImageAspec
     viewInfo.subresourceRange.baseMipLevel = 0;
     viewInfo.subresourceRange.levelCount = mipLevels;
 
-    if (vkCreateImageView(device_, &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+    if (vkCreateImageView(device_, &viewInfo, HostAllocator::callbacks(HostAllocator::ObjectType::Image), &imageView) != VK_SUCCESS) {
         throw std::runtime_error("failed to creat image view!");
     }
 
@@ -1813,14 +2279,51 @@ uint32_t Vulkan::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags prope
     throw std::runtime_error("failed to find suitable memory type!");
 }
 
-void Vulkan::copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size) {
-    auto commandBuffer = beginSingleTimeCommands();
-    
-    VkBufferCopy copyRegion{};
-    copyRegion.size = size;
-    vkCmdCopyBuffer(commandBuffer, src, dst, 1, &copyRegion);
+// straight into the buffer when the CPU can see its memory, otherwise through a staging copy the
+// next frame records ahead of its render pass
+void Vulkan::upload(Buffer& buffer, const void* data, VkDeviceSize size, VkDeviceSize offset) {
+    PROFILE_SCOPE("upload");
 
-    endSingleTimeCommands(commandBuffer, transferQueue_);
+    if (buffer.hostVisible()) {
+        memcpy(static_cast<char*>(buffer.map(buffer.size_)) + offset, data, size);
+        return ;
+    }
+
+    BufferUpload pending;
+    pending.staging_ = std::make_unique<Buffer>(physicalDevice_, device_, allocator_.get());
+    pending.staging_->size_ = size;
+    pending.staging_->usage_ = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    pending.staging_->sharingMode_ = VK_SHARING_MODE_EXCLUSIVE;
+    pending.staging_->memoryProperties_ = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    pending.staging_->memoryUsage_ = Tools::MemoryUsage::Upload;
+    pending.staging_->memoryTag_ = Tools::MemoryTag::Staging;
+    pending.staging_->init();
+
+    memcpy(pending.staging_->map(size), data, size);
+    pending.staging_->unMap();
+
+    pending.buffer_ = buffer.buffer();
+    pending.region_.size = size;
+    pending.region_.dstOffset = offset;
+    bufferUploads_.push_back(std::move(pending));
+}
+
+void Vulkan::recordBufferUploads(VkCommandBuffer commandBuffer) {
+    if (bufferUploads_.empty()) {
+        return ;
+    }
+
+    for (auto& pending : bufferUploads_) {
+        vkCmdCopyBuffer(commandBuffer, pending.staging_->buffer(), pending.buffer_, 1, &pending.region_);
+        retire(pending.staging_);
+    }
+    bufferUploads_.clear();
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
 }
 
 VkCommandBuffer Vulkan::beginSingleTimeCommands() {
@@ -1856,27 +2359,53 @@ void Vulkan::endSingleTimeCommands(VkCommandBuffer commandBuffer, VkQueue queue)
     vkFreeCommandBuffers(device_, commandPool_->commanddPool(), 1, &commandBuffer);
 }
 
-void Vulkan::fillColor(uint32_t index) {
+void Vulkan::fillColor(uint32_t index, float edge) {
+    auto& point = lineVertices_[index];
+    // brush.frag turns the distance into coverage; deeper than a full pixel counts as full
+    edge = std::min(edge, Line::inside_);
+
+    glm::vec4 color{};
     switch (color_) {
     case Color::Write:
-        lineVertices_[index].color_ = glm::vec4(write3_, 0.0f);
+        // the eraser stays hard edged, a half erased pixel would need the ink it erases
+        if (edge < 0.0f) {
+            return ;
+        }
+        color = glm::vec4(write3_, 0.0f);
+        edge = Line::inside_;
         break;
     case Color::Red:
-        lineVertices_[index].color_ = glm::vec4(red3_, 1.0f);
+        color = glm::vec4(red3_, 1.0f);
         break;
     case Color::Green:
-        lineVertices_[index].color_ = glm::vec4(green3_, 1.0f);
+        color = glm::vec4(green3_, 1.0f);
         break;
     case Color::Blue:
-        lineVertices_[index].color_ = glm::vec4(blue3_, 1.0f);
+        color = glm::vec4(blue3_, 1.0f);
         break;
     case Color::Black:
-        lineVertices_[index].color_ = glm::vec4(black3_, 1.0f);
+        color = glm::vec4(black3_, 1.0f);
         break;
     }
+
+    if (point.color_.a > 0.0f && color_ != Color::Write) {
+        if (point.color_ == color) {
+            edge = std::max(edge, point.texCoord_.x);
+        } else if (edge < point.texCoord_.x) {
+            // the soft edge of this stroke leaves the pixel to the ink covering more of it
+            return ;
+        }
+    }
+
+    point.color_ = color;
+    point.texCoord_.x = edge;
+    lineDirtyBegin_ = std::min(lineDirtyBegin_, index);
+    lineDirtyEnd_ = std::max(lineDirtyEnd_, index + 1);
 }
 
 void Vulkan::changePoint() {
+    PROFILE_SCOPE("changePoint");
+
     auto deltaX = prevCursorRelative_.x - currCursorRelative_.x;
     auto deltaY = prevCursorRelative_.y - currCursorRelative_.y;
 
@@ -1888,10 +2417,11 @@ void Vulkan::changePoint() {
     int ex = std::max(prevCursorRelative_.x, currCursorRelative_.x);
     int ey = std::max(prevCursorRelative_.y, currCursorRelative_.y);
 
-    bx -= lineWidth_ / 2.0f;
-    ex += lineWidth_ / 2.0f;
-    by -= lineWidth_ / 2.0f;
-    ey += lineWidth_ / 2.0f;
+    // one more pixel around for the antialiased edge
+    bx -= lineWidth_ / 2.0f + 1.0f;
+    ex += lineWidth_ / 2.0f + 1.0f;
+    by -= lineWidth_ / 2.0f + 1.0f;
+    ey += lineWidth_ / 2.0f + 1.0f;
 
 #ifdef DEBUG_CHANGE_POINT
     std::cout << "------change point------" << std::endl;
@@ -1916,10 +2446,11 @@ void Vulkan::changePoint() {
                 if (!validPoint(x, y)) {
                     continue;
                 }
-                if (std::abs(x - currCursorRelative_.x) <= lineWidth_) {
+                auto edge = lineWidth_ - std::abs(x - currCursorRelative_.x);
+                if (edge > -Line::inside_) {
                     t++;
                     auto index = lineVertexMaps_[(y + swapChain_->height() / 2) * swapChain_->width() + (x + swapChain_->width() / 2)];
-                    fillColor(index);
+                    fillColor(index, edge);
                 }
             }
         }
@@ -1938,10 +2469,11 @@ void Vulkan::changePoint() {
             if (!validPoint(x, y)) {
                 continue;
             }
-            if (Tools::pointToLineLength(a, b, x, y) <= lineWidth_) {
+            auto edge = lineWidth_ - Tools::pointToLineLength(a, b, x, y);
+            if (edge > -Line::inside_) {
                 t++;
                 auto index = lineVertexMaps_[(y + swapChain_->height() / 2) * swapChain_->width() + (x + swapChain_->width() / 2)];
-                fillColor(index);
+                fillColor(index, edge);
             }
         }
     }
@@ -1961,69 +2493,413 @@ bool Vulkan::validPoint(int x, int y) {
 void Vulkan::processText() {
     if (text_.size() >= 6 && text_.substr(1, 5) == "load:") {
         auto resource = Tools::rmSpace({text_.begin() + 6, text_.end()});
-        updateCanvasTexturePath_ = "../textures/" + Tools::rmSpace(resource);
-        updateTexture();
+        loadTexture("../textures/" + resource);
+    } else if (text_.substr(1) == "mem") {
+        logMemory();
+    } else {
+        commitText(text_.substr(1));
     }
 }
 
-void Vulkan::updateTexture() {
-    int texWidth, texHeight, texChannels;
-    auto start = Timer::nowMilliseconds();
-    auto pixel = stbi_load(updateCanvasTexturePath_.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    auto end = Timer::nowMilliseconds();
-    std::cout << std::format("ms: {}", end - start);
-    if (!pixel) {
+void Vulkan::commitText(const std::string& text) {
+    double xpos, ypos;
+    glfwGetCursorPos(windows_, &xpos, &ypos);
+
+    TextBlock block;
+    block.text_ = Tools::decodeUtf8(text);
+    block.origin_ = glm::vec2(xpos - swapChain_->width() / 2.0f, -(ypos - swapChain_->height() / 2.0f));
+    block.size_ = fontSize_;
+    switch (color_) {
+    case Color::Red:
+        block.color_ = red3_;
+        break;
+    case Color::Green:
+        block.color_ = green3_;
+        break;
+    case Color::Blue:
+        block.color_ = blue3_;
+        break;
+    default:
+        // the eraser has no color to write with
+        block.color_ = black3_;
+        break;
+    }
+
+    stampText(block);
+    textBlocks_.push_back(std::move(block));
+}
+
+void Vulkan::stampText(const TextBlock& block) {
+    PROFILE_SCOPE("stampText");
+
+    // every glyph is blended in right after its lookup, so evictions along the way don't matter
+    glyphCache_->beginFrame(frameIndex_, completedFrame_);
+    TextRaster raster(glyphCache_->atlas(), config_.fontSpread_);
+    auto scale = block.size_ / config_.fontBaseSize_;
+    glm::vec4 color(block.color_, 0.0f);
+
+    auto x = block.origin_.x;
+    for (auto c : block.text_) {
+        auto character = glyphCache_->glyph(c);
+        raster.glyph(x, block.origin_.y, character, scale, [&](int px, int py, float coverage) {
+            if (!validPoint(px, py)) {
+                return ;
+            }
+            auto index = lineVertexMaps_[(py + swapChain_->height() / 2) * swapChain_->width() + (px + swapChain_->width() / 2)];
+            auto& point = lineVertices_[index];
+            // fold a brush edge's coverage into its alpha first, text is composited over whole pixels
+            point.color_.a *= std::clamp(point.texCoord_.x + Line::inside_, 0.0f, 1.0f);
+            point.texCoord_.x = Line::inside_;
+            color.a = coverage;
+            TextRaster::blendOver(&point.color_[0], &color[0]);
+            lineDirtyBegin_ = std::min(lineDirtyBegin_, index);
+            lineDirtyEnd_ = std::max(lineDirtyEnd_, index + 1);
+        });
+        x += character.advance_ * scale;
+    }
+}
+
+void Vulkan::logMemory() const {
+    constexpr double MiB = 1024.0 * 1024.0;
+    auto stats = allocator_->stats();
+    for (size_t i = 0; i < stats.tags_.size(); i++) {
+        if (stats.tags_[i].count_ == 0) {
+            continue;
+        }
+        std::cout << std::format("{:<12} {:>9.2f} MiB in {} allocations", Tools::memoryTagName(static_cast<Tools::MemoryTag>(i)), stats.tags_[i].bytes_ / MiB, stats.tags_[i].count_) << std::endl;
+    }
+    for (size_t i = 0; i < stats.heaps_.size(); i++) {
+        const auto& heap = stats.heaps_[i];
+        std::cout << std::format("heap {}{}: {:.2f} MiB reserved by us, {:.2f} / {:.2f} MiB used{}", i, heap.deviceLocal_ ? " (device local)" : "", heap.reserved_ / MiB, heap.usage_ / MiB, heap.budget_ / MiB, stats.budgetExtension_ ? "" : " (no budget extension, heap size shown)") << std::endl;
+    }
+}
+
+std::unique_ptr<TiledImage> Vulkan::decodeCanvasTiles(const std::string& path, const AssetPack* pack, uint32_t tileSize, uint32_t slots, uint32_t maxExtent) {
+    PROFILE_SCOPE("decode texture");
+    if (pack) {
+        if (auto baked = pack->find("textures/" + std::filesystem::path(path).filename().string(), path)) {
+            // already RGBA8, sliced straight out of the mapping
+            return std::make_unique<TiledImage>(baked->data_, baked->width_, baked->height_, tileSize, slots, maxExtent);
+        }
+    }
+    // stb has no incremental decode, the whole image is held only until it is sliced
+    int width, height, channels;
+    auto pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (!pixels) {
+        return nullptr;
+    }
+    auto tiles = std::make_unique<TiledImage>(pixels, static_cast<uint32_t>(width), static_cast<uint32_t>(height), tileSize, slots, maxExtent);
+    stbi_image_free(pixels);
+    return tiles;
+}
+
+uint32_t Vulkan::canvasTileSlots() const {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+    return std::max(1u, std::min(config_.canvasTileSlots_, properties.limits.maxImageArrayLayers));
+}
+
+uint32_t Vulkan::canvasMaxExtent() const {
+    auto extent = std::max(swapChain_->width(), swapChain_->height());
+    // the window may grow up to the monitor, keep the levels that will need
+    if (!config_.headless_) {
+        if (auto monitor = glfwGetPrimaryMonitor()) {
+            if (auto mode = glfwGetVideoMode(monitor)) {
+                extent = std::max(extent, static_cast<uint32_t>(std::max(mode->width, mode->height)));
+            }
+        }
+    }
+    return extent;
+}
+
+std::vector<TiledImage::Upload> Vulkan::showCanvas(TiledImage& tiles) const {
+    // the plane is axis aligned and its first and last corners are opposite; only the part of it
+    // inside the window is asked for, at the pixels that part covers
+    const auto& a = canvasVertices_.front();
+    const auto& b = canvasVertices_.back();
+    auto axis = [](float p0, float p1, float t0, float t1, float half, float& s0, float& s1) {
+        auto low = std::max(std::min(p0, p1), -half), high = std::min(std::max(p0, p1), half);
+        if (high <= low || p0 == p1) {
+            s0 = s1 = t0;
+            return 1u;
+        }
+        auto at = [&](float p) { return t0 + (t1 - t0) * (p - p0) / (p1 - p0); };
+        s0 = std::min(at(low), at(high));
+        s1 = std::max(at(low), at(high));
+        return std::max(1u, static_cast<uint32_t>(std::ceil(high - low)));
+    };
+    TiledImage::Rect view;
+    auto width = axis(a.position_.x, b.position_.x, a.texCoord_.x, b.texCoord_.x, swapChain_->width() / 2.0f, view.x0_, view.x1_);
+    auto height = axis(a.position_.y, b.position_.y, a.texCoord_.y, b.texCoord_.y, swapChain_->height() / 2.0f, view.y0_, view.y1_);
+    return tiles.update(view, width, height);
+}
+
+std::unique_ptr<Image> Vulkan::createCanvasImage(uint32_t slots) {
+    auto families = queueFamilies_.sets();
+    auto image = std::make_unique<Image>(physicalDevice_, device_, allocator_.get());
+    image->imageType_ = VK_IMAGE_TYPE_2D;
+    image->arrayLayers_ = slots;
+    image->mipLevles_ = 1;
+    image->format_ = VK_FORMAT_R8G8B8A8_SRGB;
+    image->extent_ = {config_.canvasTileSize_, config_.canvasTileSize_, 1};
+    image->queueFamilyIndexCount_ = static_cast<uint32_t>(families.size());
+    image->pQueueFamilyIndices_ = families.data();
+    image->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+    image->tiling_ = VK_IMAGE_TILING_OPTIMAL;
+    image->usage_ = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    image->memoryProperties_ = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    image->memoryUsage_ = Tools::MemoryUsage::GpuOnly;
+    image->memoryTag_ = Tools::MemoryTag::Canvas;
+    image->viewType_ = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    image->samples_ = VK_SAMPLE_COUNT_1_BIT;
+    image->subresourcesRange_ = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, slots};
+    image->init();
+    return image;
+}
+
+std::unique_ptr<Buffer> Vulkan::createTileTable(const TiledImage& tiles) {
+    auto table = std::make_unique<Buffer>(physicalDevice_, device_, allocator_.get());
+    table->size_ = sizeof(uint32_t) * tiles.maxTableSize();
+    table->usage_ = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    table->sharingMode_ = VK_SHARING_MODE_EXCLUSIVE;
+    table->memoryProperties_ = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    table->memoryUsage_ = Tools::MemoryUsage::Dynamic;
+    table->memoryTag_ = Tools::MemoryTag::Storage;
+    table->init();
+    return table;
+}
+
+void Vulkan::writeTileTable(Buffer& buffer, const TiledImage& tiles) {
+    const auto& table = tiles.table();
+    VkDeviceSize size = sizeof(uint32_t) * table.size();
+    auto data = buffer.map(size);
+    memcpy(data, table.data(), size);
+    buffer.unMap();
+}
+
+std::unique_ptr<Buffer> Vulkan::stageTiles(const std::vector<TiledImage::Upload>& uploads, std::vector<VkBufferImageCopy>& regions) {
+    if (uploads.empty()) {
+        return nullptr;
+    }
+    VkDeviceSize tileBytes = static_cast<VkDeviceSize>(config_.canvasTileSize_) * config_.canvasTileSize_ * 4;
+    VkDeviceSize size = tileBytes * uploads.size();
+
+    auto staging = std::make_unique<Buffer>(physicalDevice_, device_, allocator_.get());
+    staging->size_ = size;
+    staging->sharingMode_ = VK_SHARING_MODE_EXCLUSIVE;
+    staging->usage_ = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    staging->memoryProperties_ = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    staging->memoryUsage_ = Tools::MemoryUsage::Upload;
+    staging->memoryTag_ = Tools::MemoryTag::Staging;
+    staging->init();
+
+    auto data = static_cast<uint8_t*>(staging->map(size));
+    for (size_t i = 0; i < uploads.size(); i++) {
+        memcpy(data + tileBytes * i, uploads[i].pixels_, tileBytes);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = tileBytes * i;
+        region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, uploads[i].slot_, 1};
+        region.imageExtent = {config_.canvasTileSize_, config_.canvasTileSize_, 1};
+        regions.push_back(region);
+    }
+    staging->unMap();
+    return staging;
+}
+
+void Vulkan::loadTexture(const std::string& path) {
+    if (textureDecode_.valid() || uploadingImage_) {
+        queuedTexturePath_ = path;
         return ;
     }
 
-    VkDeviceSize size = texWidth * texHeight * 4;
-
-    canvasImage_ = std::make_unique<Image>(physicalDevice_, device_);
-    canvasImage_->imageType_ = VK_IMAGE_TYPE_2D;
-    canvasImage_->arrayLayers_ = 1;
-    canvasImage_->mipLevles_ = 1;
-    canvasImage_->format_ = VK_FORMAT_R8G8B8A8_SRGB;
-    canvasImage_->extent_ = {static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1};
-    canvasImage_->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
-    canvasImage_->pQueueFamilyIndices_ = queueFamilies_.sets().data();
-    canvasImage_->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
-    canvasImage_->tiling_ = VK_IMAGE_TILING_OPTIMAL;
-    canvasImage_->usage_ = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-    canvasImage_->memoryProperties_ = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-    canvasImage_->viewType_ = VK_IMAGE_VIEW_TYPE_2D;
-    canvasImage_->samples_ = VK_SAMPLE_COUNT_1_BIT;
-    canvasImage_->subresourcesRange_ = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
-    canvasImage_->init();
-    
-    std::unique_ptr<Buffer> staginBuffer = std::make_unique<Buffer>(physicalDevice_, device_);
-    staginBuffer->size_ = size;
-    staginBuffer->queueFamilyIndexCount_ = static_cast<uint32_t>(queueFamilies_.sets().size());
-    staginBuffer->pQueueFamilyIndices_ = queueFamilies_.sets().data();
-    staginBuffer->sharingMode_ = queueFamilies_.multiple() ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
-    staginBuffer->usage_ = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    staginBuffer->memoryProperties_ = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-    staginBuffer->init();
-    
-    auto data = staginBuffer->map(size);
-    memcpy(data, pixel, size);
-    staginBuffer->unMap();
+    textureDecode_ = std::async(std::launch::async, [path, pack = assetPack_.get(), tileSize = config_.canvasTileSize_, slots = canvasTileSlots(), maxExtent = canvasMaxExtent()]() {
+        DecodedImage image;
+        image.path_ = path;
+        image.tiles_ = decodeCanvasTiles(path, pack, tileSize, slots, maxExtent);
+        return image;
+    });
+}
 
-    VkImageSubresourceRange range{1, 0, 1, 0, 1};
-    VkBufferImageCopy region{};
-    region.imageOffset = {0, 0, 0};
-    region.imageExtent = {static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1};
-    region.imageSubresource = {1, 0, 0, 1};
+void Vulkan::pollTextureLoad() {
+    if (uploadingImage_) {
+        if (vkGetFenceStatus(device_, textureUploadFence_->fence()) != VK_SUCCESS) {
+            return ;
+        }
+        PROFILE_SCOPE("swap canvas texture");
+        vkResetFences(device_, 1, textureUploadFence_->fencePtr());
+        textureUploadCommands_.reset();
+        textureStaging_.reset();
+
+        // the frame in flight may still sample the old image through the old descriptor set
+        retire(canvasImage_);
+        retire(canvasTileTable_);
+        canvasImage_ = std::move(uploadingImage_);
+        canvasTileTable_ = std::move(uploadingTileTable_);
+        canvasTiles_ = std::move(uploadingTiles_);
+        createCanvasDescriptorSet();
+        textureUploaded_ = true;
+        // the window may have been resized while the upload ran
+        canvasViewChanged_ = true;
+
+        if (!queuedTexturePath_.empty()) {
+            loadTexture(std::exchange(queuedTexturePath_, {}));
+        }
+        return ;
+    }
+
+    if (!textureDecode_.valid() || textureDecode_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return ;
+    }
+    auto decoded = textureDecode_.get();
+    if (!decoded.tiles_) {
+        std::cerr << "failed to load texture " << decoded.path_ << std::endl;
+        if (!queuedTexturePath_.empty()) {
+            loadTexture(std::exchange(queuedTexturePath_, {}));
+        }
+        return ;
+    }
+
+    PROFILE_SCOPE("submit texture upload");
+    uploadingTiles_ = std::move(decoded.tiles_);
+    uploadingImage_ = createCanvasImage(uploadingTiles_->slots());
+    uploadingTileTable_ = createTileTable(*uploadingTiles_);
+
+    std::vector<VkBufferImageCopy> regions;
+    textureStaging_ = stageTiles(showCanvas(*uploadingTiles_), regions);
+    writeTileTable(*uploadingTileTable_, *uploadingTiles_);
+
+    textureUploadCommands_ = std::make_unique<CommandBuffer>(device_);
+    textureUploadCommands_->commandPool_ = transferCommandPool_->commanddPool();
+    textureUploadCommands_->level_ = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    textureUploadCommands_->commandBufferCount_ = 1;
+    textureUploadCommands_->init();
+    auto commandBuffer = textureUploadCommands_->commandBuffer();
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, uploadingTiles_->slots()};
+    // the transfer queue can't name fragment stages, the graphics frame finishes the transition
+    Tools::setImageLayout(commandBuffer, uploadingImage_->image(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    vkCmdCopyBufferToImage(commandBuffer, textureStaging_->buffer(), uploadingImage_->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+    vkEndCommandBuffer(commandBuffer);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = textureUploadSemaphore_->semaphorePtr();
+    if (vkQueueSubmit(transferQueue_, 1, &submitInfo, textureUploadFence_->fence()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit texture upload!");
+    }
+}
+
+void Vulkan::updateCanvasTiles() {
+    if (!canvasViewChanged_) {
+        return ;
+    }
+    canvasViewChanged_ = false;
+
+    tileStaging_ = stageTiles(showCanvas(*canvasTiles_), tileRegions_);
+    if (canvasTiles_->takeTableDirty()) {
+        writeTileTable(*canvasTileTable_, *canvasTiles_);
+    }
+}
+
+void Vulkan::recordTileUploads(VkCommandBuffer commandBuffer) {
+    if (!tileStaging_) {
+        return ;
+    }
+
+    // slots not written keep their tiles, so the old layout is kept rather than discarded
+    VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, canvasTiles_->slots()};
+    Tools::setImageLayout(commandBuffer, canvasImage_->image(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    vkCmdCopyBufferToImage(commandBuffer, tileStaging_->buffer(), canvasImage_->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(tileRegions_.size()), tileRegions_.data());
+    Tools::setImageLayout(commandBuffer, canvasImage_->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+    retire(tileStaging_);
+    tileRegions_.clear();
+}
+
+void Vulkan::recordTextureLoad(VkCommandBuffer commandBuffer) {
+    if (!textureUploaded_) {
+        return ;
+    }
+    VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, canvasTiles_->slots()};
+    Tools::setImageLayout(commandBuffer, canvasImage_->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
+
+std::vector<uint8_t> Vulkan::readback() {
+    PROFILE_SCOPE("readback");
+
+    if (!swapChain_->offscreen()) {
+        return {};
+    }
+
+    vkWaitForFences(device_, 1, inFlightFences_->fencePtr(), VK_TRUE, UINT64_MAX);
+
+    auto width = swapChain_->width(), height = swapChain_->height();
+    VkDeviceSize size = static_cast<VkDeviceSize>(width) * height * 4;
+
+    Buffer readbackBuffer(physicalDevice_, device_, allocator_.get());
+    readbackBuffer.size_ = size;
+    readbackBuffer.usage_ = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    readbackBuffer.sharingMode_ = VK_SHARING_MODE_EXCLUSIVE;
+    readbackBuffer.memoryProperties_ = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    readbackBuffer.memoryUsage_ = Tools::MemoryUsage::Readback;
+    readbackBuffer.memoryTag_ = Tools::MemoryTag::Staging;
+    readbackBuffer.init();
 
     auto cmdBuffer = beginSingleTimeCommands();
-        Tools::setImageLayout(cmdBuffer, canvasImage_->image(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+        // the render pass left the image in TRANSFER_SRC_OPTIMAL, only its writes need to be made visible
+        VkImageMemoryBarrier imageBarrier{};
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.image = swapChain_->image(renderedImage_);
+        imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        imageBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
 
-        vkCmdCopyBufferToImage(cmdBuffer, staginBuffer->buffer(), canvasImage_->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        VkBufferImageCopy region{};
+        region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        region.imageExtent = {width, height, 1};
+        vkCmdCopyImageToBuffer(cmdBuffer, swapChain_->image(renderedImage_), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer.buffer(), 1, &region);
+
+        VkBufferMemoryBarrier bufferBarrier{};
+        bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        bufferBarrier.buffer = readbackBuffer.buffer();
+        bufferBarrier.size = size;
+        bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+    endSingleTimeCommands(cmdBuffer, graphicsQueue_);
+
+    std::vector<uint8_t> pixels(size);
+    auto data = readbackBuffer.map(size);
+    memcpy(pixels.data(), data, size);
+    readbackBuffer.unMap();
+
+    return pixels;
+}
 
-        Tools::setImageLayout(cmdBuffer, canvasImage_->image(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
-        
-    endSingleTimeCommands(cmdBuffer, transferQueue_);
+bool Vulkan::saveFrame(const std::string& path) {
+    auto pixels = readback();
+    if (pixels.empty()) {
+        return false;
+    }
 
-    createCanvasDescriptorSet();
+    auto width = static_cast<int>(swapChain_->width()), height = static_cast<int>(swapChain_->height());
+    return stbi_write_png(path.c_str(), width, height, 4, pixels.data(), width * 4) != 0;
 }
 
 VKAPI_ATTR VkBool32 VKAPI_CALL Vulkan::debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, 
@@ -0,0 +1,70 @@
+// Bakes everything Main would otherwise decode at startup into one asset pack: compiled shaders,
+// textures decoded to RGBA8 and the preloaded glyph atlas. Run from bin/ like Main, after
+// shaders/compile.sh; Main picks the pack up from Config::assetPackPath_.
+#include "AssetPack.h"
+#include "Config.h"
+#include "GlyphCache.h"
+#include "Tools.h"
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <stb_image.h>
+
+int main(int argc, char** argv) {
+    Config config;
+    std::string output = config.assetPackPath_;
+    std::string shaders = "../shaders/spv";
+    std::string textures = "../textures";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--output" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--shaders" && i + 1 < argc) {
+            shaders = argv[++i];
+        } else if (arg == "--textures" && i + 1 < argc) {
+            textures = argv[++i];
+        }
+    }
+
+    try {
+        AssetPack::Writer writer;
+
+        for (const auto& entry : std::filesystem::directory_iterator(shaders)) {
+            if (entry.path().extension() != ".spv") {
+                continue;
+            }
+            auto code = Tools::readFile(entry.path().string());
+            writer.add("shaders/" + entry.path().filename().string(), code.data(), code.size(), 0, 0, entry.path().string());
+            std::cout << "shader  " << entry.path().filename().string() << std::endl;
+        }
+
+        for (const auto& entry : std::filesystem::directory_iterator(textures)) {
+            int width, height, channels;
+            auto pixels = stbi_load(entry.path().string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
+            // ktx and anything else stb can't read keep loading from source
+            if (!pixels) {
+                continue;
+            }
+            writer.add("textures/" + entry.path().filename().string(), pixels, static_cast<size_t>(width) * height * 4, width, height, entry.path().string());
+            stbi_image_free(pixels);
+            std::cout << "texture " << entry.path().filename().string() << " " << width << "x" << height << std::endl;
+        }
+
+        // the same glyphs Vulkan::loadChars preloads
+        GlyphCache glyphs(config.fontPath_, config.fontBaseSize_, config.fontSpread_, config.glyphAtlasSize_);
+        std::vector<uint32_t> codepoints(128);
+        for (uint32_t i = 0; i < codepoints.size(); i++) {
+            codepoints[i] = i;
+        }
+        glyphs.preload(codepoints);
+        glyphs.bake(writer);
+        std::cout << "glyphs  " << glyphs.size() << std::endl;
+
+        writer.write(output);
+        std::cout << "wrote " << output << " (version " << AssetPack::version_ << ")" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
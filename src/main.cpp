@@ -1,12 +1,36 @@
 #include "Vulkan.h"
 #include <exception>
 #include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    Config config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            config.headless_ = true;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            config.headlessFrames_ = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--output" && i + 1 < argc) {
+            config.readbackPath_ = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            config.tracePath_ = argv[++i];
+        } else if (arg == "--host-allocations") {
+            config.trackHostAllocations_ = true;
+        } else if (arg == "--pack" && i + 1 < argc) {
+            config.assetPackPath_ = argv[++i];
+        } else if (arg == "--no-pack") {
+            config.assetPackPath_.clear();
+        } else if (arg == "--host-arena") {
+            config.trackHostAllocations_ = true;
+            config.hostArena_ = true;
+        }
+    }
 
-int main() {
     try {
-        Vulkan vulkan("Game", 800, 600);
+        Vulkan vulkan("Game", 800, 600, config);
         vulkan.run();
     } catch (std::exception e) {
         std::cerr << e.what() << std::endl;
     }
-}
\ No newline at end of file
+}